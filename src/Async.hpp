@@ -0,0 +1,385 @@
+#ifndef ASYNC_H
+#define ASYNC_H
+
+/*! \file Async.hpp
+ * \brief Coroutine interfaces of the readers and the writer. They need C++20, the rest of the library is C++17:
+ * this header is empty for the older standards.
+ */
+
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+
+#include "FeedReader.hpp"
+#include "Reader.hpp"
+#include "YamlReader.hpp"
+#include "ObjectWriter.hpp"
+#include <algorithm>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*! \brief A coroutine returning a value of type _T_, started when it is awaited.
+ *
+ * A Task is awaited by another coroutine with <pre> co_await </pre>. The outermost task is started by the event
+ * loop with start(), and runs until its first suspension on an input or output not ready.
+ * The exceptions are forwarded to the awaiting coroutine, or by result().
+ */
+template<class T>
+class Task
+{
+    public:
+        class promise_type
+        {
+            public:
+                Task get_return_object() {
+                    return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+
+                std::suspend_always initial_suspend() noexcept {
+                    return {}; }
+
+                /*! Resume the awaiting coroutine at the end of the task.
+                 */
+                struct FinalAwaiter
+                {
+                    bool await_ready() noexcept {
+                        return false; }
+
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+                    {
+                        std::coroutine_handle<> next = handle.promise().continuation;
+                        return next ? next : std::noop_coroutine();
+                    }
+
+                    void await_resume() noexcept {}
+                };
+
+                FinalAwaiter final_suspend() noexcept {
+                    return {}; }
+
+                void return_value(T result) {
+                    value = std::move(result); }
+
+                void unhandled_exception() {
+                    error = std::current_exception(); }
+
+            private:
+                std::optional<T> value;                 //!< The result of the task.
+                std::exception_ptr error;               //!< The exception thrown by the task.
+                std::coroutine_handle<> continuation;   //!< The coroutine awaiting the task.
+
+                friend class Task;
+        };
+
+        Task(Task&& task) noexcept : handle(std::exchange(task.handle, nullptr)) {}
+
+        ~Task()
+        {
+            if(handle)
+                handle.destroy();
+        }
+
+        Task& operator= (Task&& task) noexcept
+        {
+            if(this != &task)
+            {
+                if(handle)
+                    handle.destroy();
+                handle = std::exchange(task.handle, nullptr);
+            }
+            return *this;
+        }
+
+        /*! \brief Start the task from a function which is not a coroutine.
+         */
+        void start() {
+            handle.resume(); }
+
+        /*! \brief Check if the task has finished.
+         */
+        bool done() const {
+            return handle.done(); }
+
+        /*! \brief Get the result of a finished task.
+         * \throw The exception thrown by the task is forwarded.
+         */
+        T result()
+        {
+            promise_type& promise = handle.promise();
+            if(promise.error)
+                std::rethrow_exception(promise.error);
+            return std::move(*promise.value);
+        }
+
+        bool await_ready() const noexcept {
+            return false; }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            handle.promise().continuation = awaiting;
+            return handle;
+        }
+
+        T await_resume() {
+            return result(); }
+
+    private:
+        std::coroutine_handle<promise_type> handle; //!< The coroutine.
+
+        explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+        Task(const Task&) = delete;
+        Task& operator= (const Task&) = delete;
+};
+
+
+/*! \brief A coroutine giving a sequence of values of type _T_, computed when the next one is asked.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * JsonReader reader(&stream);
+ * for(Variant& doc : readDocuments(reader))
+ *     process(doc);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The value given by the iterator is valid until the next increment.
+ */
+template<class T>
+class Generator
+{
+    public:
+        class promise_type
+        {
+            public:
+                Generator get_return_object() {
+                    return Generator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+
+                std::suspend_always initial_suspend() noexcept {
+                    return {}; }
+
+                std::suspend_always final_suspend() noexcept {
+                    return {}; }
+
+                std::suspend_always yield_value(T& value) noexcept
+                {
+                    current = &value;
+                    return {};
+                }
+
+                std::suspend_always yield_value(T&& value) noexcept
+                {
+                    current = &value;
+                    return {};
+                }
+
+                void return_void() {}
+
+                void unhandled_exception() {
+                    error = std::current_exception(); }
+
+            private:
+                T* current;                 //!< The last value given.
+                std::exception_ptr error;   //!< The exception thrown by the generator.
+
+                friend class Generator;
+        };
+
+        /*! \brief Iterator on the values, computing the next one when it is incremented.
+         */
+        class iterator
+        {
+            public:
+                bool operator== (std::default_sentinel_t) const {
+                    return handle.done(); }
+
+                iterator& operator++ ()
+                {
+                    advance(handle);
+                    return *this;
+                }
+
+                T& operator* () const {
+                    return *handle.promise().current; }
+
+            private:
+                std::coroutine_handle<promise_type> handle;
+
+                explicit iterator(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+                friend class Generator;
+        };
+
+        Generator(Generator&& generator) noexcept : handle(std::exchange(generator.handle, nullptr)) {}
+
+        ~Generator()
+        {
+            if(handle)
+                handle.destroy();
+        }
+
+        /*! \brief Compute the first value, and get an iterator on it.
+         * \throw The exceptions of the generator are forwarded by begin() and the increments.
+         */
+        iterator begin()
+        {
+            advance(handle);
+            return iterator(handle);
+        }
+
+        std::default_sentinel_t end() const {
+            return std::default_sentinel; }
+
+    private:
+        std::coroutine_handle<promise_type> handle; //!< The coroutine.
+
+        explicit Generator(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+        static void advance(std::coroutine_handle<promise_type> handle)
+        {
+            handle.resume();
+            if(handle.promise().error)
+                std::rethrow_exception(std::exchange(handle.promise().error, nullptr));
+        }
+
+        Generator(const Generator&) = delete;
+        Generator& operator= (const Generator&) = delete;
+};
+
+
+/*! \brief Give the documents of _reader_ one by one, each one being read when it is asked.
+ * \see BasicReader::next()
+ */
+template<class Dialect>
+Generator<Variant> readDocuments(BasicReader<Dialect>& reader)
+{
+    Variant doc;
+    while(reader.next(doc))
+        co_yield doc;
+}
+
+/*! \brief Give the documents of _reader_ one by one, each one being read when it is asked.
+ * \see YamlReader::next()
+ */
+inline Generator<Variant> readDocuments(YamlReader& reader)
+{
+    Variant doc;
+    while(reader.next(doc))
+        co_yield doc;
+}
+
+
+/*! \brief Class reading JSON documents from an asynchronous source of bytes, without blocking its thread.
+ *
+ * The source is any object with a method <pre> read(char* buffer, size_t size) </pre> returning an awaitable of
+ * the number of bytes read, 0 at the end of the input. The chunks received are parsed by a FeedReader, so a
+ * document can be split anywhere:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * Task<size_t> serve(Connection& connection)
+ * {
+ *     AsyncReader<Connection> reader(connection);
+ *     AsyncWriter<Connection> writer(connection);
+ *     Variant request, response;
+ *     while(co_await reader.next(request))
+ *     {
+ *         handle(request, response);
+ *         co_await writer.write(response);
+ *     }
+ *     co_return 0;
+ * }
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * \see FeedReader, Task
+ */
+template<class Source>
+class AsyncReader
+{
+    public:
+        /*! \brief Construct a reader on _source_, reading at most _bufferSize_ bytes at once.
+         */
+        explicit AsyncReader(Source& source, size_t bufferSize = 65536) :
+            source(source),
+            buffer(bufferSize),
+            ended(false)
+        {}
+
+        /*! \brief Get the parser, to set its options.
+         */
+        FeedReader& getReader() {
+            return reader; }
+
+        /*! \brief Read the next document, waiting for the source when the buffered input is not enough.
+         *
+         * \return false if the end of the input is reached before any new document, true otherwise.
+         * \throw std::invalid_argument is thrown if the input is not valid JSON.
+         */
+        Task<bool> next(Variant& result)
+        {
+            while(!reader.next(result))
+            {
+                if(ended)
+                    co_return false;
+                size_t count = co_await source.read(buffer.data(), buffer.size());
+                if(count == 0)
+                {
+                    ended = true;
+                    reader.finish();
+                }
+                else
+                    reader.feed(std::string_view(buffer.data(), count));
+            }
+            co_return true;
+        }
+
+    private:
+        Source& source;             //!< The input.
+        std::vector<char> buffer;   //!< The bytes read.
+        FeedReader reader;          //!< The parser of the chunks.
+        bool ended;                 //!< The end of the input is reached.
+};
+
+
+/*! \brief Class writing documents to an asynchronous output, without blocking its thread.
+ *
+ * The sink is any object with a method <pre> write(const char* data, size_t size) </pre> returning an awaitable,
+ * resumed when the data is written (or copied in an output buffer). The document is formatted in memory by an
+ * ObjectWriter with _Format_ (compact JSON by default, see Format.hpp), then given to the sink by blocks: the writer
+ * waits for each block to be drained before the next one.
+ * \see ObjectWriter, AsyncReader
+ */
+template<class Sink, class Format = JsonFormat>
+class AsyncWriter
+{
+    public:
+        /*! \brief Construct a writer on _sink_, giving it at most _blockSize_ bytes at once.
+         */
+        explicit AsyncWriter(Sink& sink, size_t blockSize = 65536) :
+            sink(sink),
+            blockSize(blockSize)
+        {}
+
+        /*! \brief Write _object_ to the sink.
+         *
+         * \return The number of bytes written.
+         */
+        Task<size_t> write(const Variant& object)
+        {
+            text.str(std::string());
+            ObjectWriter<Format> writer(&text);
+            writer.write(object);
+
+            const std::string data = text.str();
+            for(size_t pos = 0; pos < data.size(); pos += blockSize)
+                co_await sink.write(data.data() + pos, std::min(blockSize, data.size() - pos));
+            co_return data.size();
+        }
+
+    private:
+        Sink& sink;                 //!< The output.
+        size_t blockSize;           //!< Maximum size of a write to the sink.
+        std::ostringstream text;    //!< The text of the document written.
+};
+
+#endif // C++20 coroutines
+
+#endif // ASYNC_H
@@ -0,0 +1,518 @@
+#include "BatchReader.hpp"
+#include "Reader.hpp"
+#include "YamlReader.hpp"
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <streambuf>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BATCHREADER_POSIX
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define BATCHREADER_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace
+{
+    /*! Size of the first read of a file, doubled while the file is larger.
+     */
+    const size_t firstReadSize = 16384;
+
+    /*! Input stream buffer on a text in memory, without copying it.
+     */
+    class MemoryBuffer : public std::streambuf
+    {
+        public:
+            explicit MemoryBuffer(std::string& text) {
+                setg(&text[0], &text[0], &text[0] + text.size()); }
+    };
+
+    /*! Parse a file with YamlReader or Reader, depending on its extension.
+     */
+    void parseByExtension(Variant& result, std::istream& input, const std::string& file)
+    {
+        std::string extension = std::filesystem::path(file).extension().string();
+        for(size_t i = 0; i < extension.size(); i++)
+            extension[i] = std::tolower(static_cast<unsigned char>(extension[i]));
+        if(extension == ".yml" || extension == ".yaml")
+        {
+            YamlReader reader(&input);
+            reader.parse(result);
+        }
+        else
+        {
+            Reader reader(&input);
+            reader.parse(result);
+        }
+    }
+
+    /*! Get the message of the error of a system call.
+     */
+    std::string systemError(int code) {
+        return std::string("BatchReader::parseFiles : Cannot read file (") + std::strerror(code) + ")"; }
+
+    /*! Read the whole file _file_ in _text_, or set _error_.
+     */
+    void readFile(const std::string& file, std::string& text, std::string& error)
+    {
+#ifdef BATCHREADER_POSIX
+        int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0)
+        {
+            error = systemError(errno);
+            return;
+        }
+        struct stat status;
+        size_t size = 0;
+        text.resize(::fstat(fd, &status) == 0 && status.st_size > 0 ? status.st_size + 1 : firstReadSize);
+        while(true)
+        {
+            ssize_t count = ::pread(fd, &text[size], text.size() - size, size);
+            if(count < 0 && errno == EINTR)
+                continue;
+            if(count < 0)
+            {
+                error = systemError(errno);
+                break;
+            }
+            if(count == 0)
+                break;
+            size += count;
+            if(size == text.size())
+                text.resize(2 * size);
+        }
+        ::close(fd);
+        text.resize(size);
+#else
+        std::ifstream strm(file.c_str(), std::ifstream::in | std::ifstream::binary);
+        if(!strm.is_open())
+        {
+            error = "BatchReader::parseFiles : Cannot open file";
+            return;
+        }
+        text.assign(std::istreambuf_iterator<char>(strm), std::istreambuf_iterator<char>());
+#endif
+    }
+
+#ifdef BATCHREADER_URING
+    /*! Submission and completion queues of io_uring, used without liburing.
+     */
+    class Ring
+    {
+        public:
+            explicit Ring(unsigned entries) :
+                fd(-1),
+                sqPtr(MAP_FAILED),
+                sqes(static_cast<io_uring_sqe*>(MAP_FAILED)),
+                pending(0)
+            {
+                io_uring_params params;
+                std::memset(&params, 0, sizeof(params));
+                fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+                // the kernels before 5.7 may miss the operations OPENAT and READ
+                if(fd < 0 || !(params.features & IORING_FEAT_FAST_POLL) || !(params.features & IORING_FEAT_SINGLE_MMAP))
+                {
+                    close();
+                    return;
+                }
+
+                // with IORING_FEAT_SINGLE_MMAP, the two rings share their mapping
+                sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+                if(cqSize > sqSize)
+                    sqSize = cqSize;
+                sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+                sqPtr = ::mmap(0, sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+                sqes = static_cast<io_uring_sqe*>(::mmap(0, sqesSize, PROT_READ | PROT_WRITE,
+                                                          MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+                if(sqPtr == MAP_FAILED || sqes == MAP_FAILED)
+                {
+                    close();
+                    return;
+                }
+
+                char* sq = static_cast<char*>(sqPtr);
+                sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+                sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+                sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+                sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+                sqEntries = params.sq_entries;
+                localTail = *sqTail;
+                cqHead = reinterpret_cast<unsigned*>(sq + params.cq_off.head);
+                cqTail = reinterpret_cast<unsigned*>(sq + params.cq_off.tail);
+                cqMask = *reinterpret_cast<unsigned*>(sq + params.cq_off.ring_mask);
+                cqes = reinterpret_cast<io_uring_cqe*>(sq + params.cq_off.cqes);
+            }
+
+            ~Ring() {
+                close(); }
+
+            bool isOpen() const {
+                return fd >= 0; }
+
+            /*! Get a free entry of the submission queue, or null if it is full.
+             */
+            io_uring_sqe* getSqe()
+            {
+                if(localTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries)
+                    return 0;
+                unsigned index = localTail & sqMask;
+                sqArray[index] = index;
+                localTail++;
+                pending++;
+                io_uring_sqe* sqe = &sqes[index];
+                std::memset(sqe, 0, sizeof(io_uring_sqe));
+                return sqe;
+            }
+
+            /*! Submit the entries, and wait for at least _waitCount_ completions.
+             */
+            bool submit(unsigned waitCount)
+            {
+                __atomic_store_n(sqTail, localTail, __ATOMIC_RELEASE);
+                while(true)
+                {
+                    long count = ::syscall(__NR_io_uring_enter, fd, pending, waitCount,
+                                           waitCount ? IORING_ENTER_GETEVENTS : 0, 0, 0);
+                    if(count >= 0)
+                    {
+                        pending -= static_cast<unsigned>(count);
+                        return true;
+                    }
+                    if(errno != EINTR && errno != EAGAIN)
+                        return false;
+                }
+            }
+
+            /*! Take the next completion, if any.
+             */
+            bool peek(io_uring_cqe& cqe)
+            {
+                unsigned head = *cqHead;
+                if(head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE))
+                    return false;
+                cqe = cqes[head & cqMask];
+                __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+
+        private:
+            int fd;
+            void* sqPtr;
+            io_uring_sqe* sqes;
+            size_t sqSize;
+            size_t sqesSize;
+            unsigned *sqHead, *sqTail, *sqArray, *cqHead, *cqTail;
+            unsigned sqMask, cqMask, sqEntries, localTail, pending;
+            io_uring_cqe* cqes;
+
+            void close()
+            {
+                if(sqes != MAP_FAILED)
+                    ::munmap(sqes, sqesSize);
+                if(sqPtr != MAP_FAILED)
+                    ::munmap(sqPtr, sqSize);
+                if(fd >= 0)
+                    ::close(fd);
+                sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+                sqPtr = MAP_FAILED;
+                fd = -1;
+            }
+
+            Ring(const Ring&) = delete;
+            Ring& operator= (const Ring&) = delete;
+    };
+#endif
+}
+
+
+//******************************** Constructors *******************************//
+BatchReader::BatchReader(unsigned threadCount, Parser parser) :
+    threadCount(threadCount),
+    queueDepth(32),
+    useUring(true),
+    parser(parser),
+    files(0),
+    jobCapacity(0),
+    readEnded(false),
+    stopped(false)
+{
+    if(this->threadCount == 0)
+        this->threadCount = std::thread::hardware_concurrency();
+    if(this->threadCount == 0)
+        this->threadCount = 1;
+    if(!this->parser)
+        this->parser = &parseByExtension;
+}
+
+
+//****************************** Public functions *******************************//
+void BatchReader::setQueueDepth(unsigned depth)
+{
+    queueDepth = depth ? depth : 1;
+}
+
+void BatchReader::setUring(bool use)
+{
+    useUring = use;
+}
+
+bool BatchReader::hasUring()
+{
+#ifdef BATCHREADER_URING
+    Ring ring(1);
+    return ring.isOpen();
+#else
+    return false;
+#endif
+}
+
+std::vector<BatchReader::Result> BatchReader::parseFiles(const std::vector<std::string>& files)
+{
+    std::vector<Result> results(files.size());
+    parseFiles(files, [&results](size_t index, Result& result) {
+        results[index] = std::move(result); });
+    return results;
+}
+
+void BatchReader::parseFiles(const std::vector<std::string>& files, Callback callback)
+{
+    this->files = &files;
+    this->callback = callback;
+    jobs.clear();
+    jobCapacity = queueDepth + 2 * threadCount;
+    readEnded = false;
+    stopped = false;
+    error = nullptr;
+
+    std::vector<std::thread> workers;
+    for(unsigned i = 0; i < threadCount; i++)
+        workers.emplace_back(&BatchReader::parseJobs, this);
+
+    try {
+        if(!useUring || !readWithUring())
+            readWithThreads();
+    } catch(...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!error)
+            error = std::current_exception();
+        stopped = true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        readEnded = true;
+    }
+    jobReady.notify_all();
+    for(size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+
+    this->files = 0;
+    this->callback = Callback();
+    jobs.clear();
+    if(error)
+        std::rethrow_exception(error);
+}
+
+
+//****************************** Private functions *******************************//
+void BatchReader::push(Job&& job)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        jobTaken.wait(lock, [this]{ return jobs.size() < jobCapacity || stopped; });
+        if(stopped)
+            return;
+        jobs.push_back(std::move(job));
+    }
+    jobReady.notify_one();
+}
+
+void BatchReader::parseJobs()
+{
+    while(true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobReady.wait(lock, [this]{ return !jobs.empty() || readEnded; });
+            if(jobs.empty())
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        jobTaken.notify_one();
+        if(isStopped())
+            continue;
+
+        Result result;
+        result.error = std::move(job.error);
+        if(result.error.empty())
+        {
+            try {
+                MemoryBuffer buffer(job.text);
+                std::istream input(&buffer);
+                parser(result.document, input, (*files)[job.index]);
+            } catch(std::exception& e) {
+                result.error = e.what();
+                result.document.setToNull();
+            }
+        }
+
+        try {
+            callback(job.index, result);
+        } catch(...) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if(!error)
+                    error = std::current_exception();
+                stopped = true;
+            }
+            jobTaken.notify_all();
+        }
+    }
+}
+
+bool BatchReader::readWithUring()
+{
+#ifdef BATCHREADER_URING
+    Ring ring(queueDepth);
+    if(!ring.isOpen())
+        return false;
+
+    /*! A file being opened or read. The file is being opened while _fd_ is negative.
+     */
+    struct Read
+    {
+        size_t index;
+        int fd;
+        size_t size;
+        std::string text;
+    };
+
+    std::vector<Read> reads(queueDepth);
+    std::vector<unsigned> freeReads;
+    for(unsigned i = queueDepth; i-- > 0; )
+        freeReads.push_back(i);
+
+    // each read in flight has at most one entry in the queues, which are larger than queueDepth
+    auto submitRead = [&ring](Read& read, unsigned slot) {
+        io_uring_sqe* sqe = ring.getSqe();
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = read.fd;
+        sqe->addr = reinterpret_cast<uintptr_t>(&read.text[read.size]);
+        sqe->len = static_cast<unsigned>(read.text.size() - read.size);
+        sqe->off = read.size;
+        sqe->user_data = slot;
+    };
+
+    size_t next = 0;
+    unsigned inFlight = 0;
+    while(true)
+    {
+        while(!freeReads.empty() && next < files->size() && !isStopped())
+        {
+            unsigned slot = freeReads.back();
+            freeReads.pop_back();
+            Read& read = reads[slot];
+            read.index = next++;
+            read.fd = -1;
+            read.size = 0;
+            io_uring_sqe* sqe = ring.getSqe();
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast<uintptr_t>((*files)[read.index].c_str());
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            sqe->user_data = slot;
+            inFlight++;
+        }
+        if(inFlight == 0)
+            break;
+        if(!ring.submit(1))
+            throw std::runtime_error(systemError(errno));
+
+        io_uring_cqe cqe;
+        while(ring.peek(cqe))
+        {
+            unsigned slot = static_cast<unsigned>(cqe.user_data);
+            Read& read = reads[slot];
+            Job job;
+            if(cqe.res < 0)
+                job.error = systemError(-cqe.res);
+            else if(read.fd < 0)
+            {
+                read.fd = cqe.res;
+                read.text.resize(firstReadSize);
+                submitRead(read, slot);
+                continue;
+            }
+            else
+            {
+                // a short read ends a regular file
+                size_t requested = read.text.size() - read.size;
+                read.size += cqe.res;
+                if(static_cast<size_t>(cqe.res) == requested)
+                {
+                    read.text.resize(2 * read.text.size());
+                    submitRead(read, slot);
+                    continue;
+                }
+                read.text.resize(read.size);
+                job.text = std::move(read.text);
+            }
+
+            if(read.fd >= 0)
+                ::close(read.fd);
+            job.index = read.index;
+            inFlight--;
+            freeReads.push_back(slot);
+            push(std::move(job));
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void BatchReader::readWithThreads()
+{
+    std::atomic<size_t> next(0);
+    auto readFiles = [this, &next]() {
+        size_t index;
+        while((index = next.fetch_add(1)) < files->size() && !isStopped())
+        {
+            Job job;
+            job.index = index;
+            readFile((*files)[index], job.text, job.error);
+            push(std::move(job));
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for(unsigned i = 1; i < queueDepth; i++)
+        readers.emplace_back(readFiles);
+    readFiles();
+    for(size_t i = 0; i < readers.size(); i++)
+        readers[i].join();
+}
+
+bool BatchReader::isStopped()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return stopped;
+}
@@ -0,0 +1,146 @@
+#ifndef BATCHREADER_H
+#define BATCHREADER_H
+
+#include "Variant.hpp"
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <istream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*! \brief Class parsing many files at once, overlapping the reads of the files and their parsing.
+ *
+ * parseFile() opens, reads and parses a file before the next one: with many small files, the time is spent
+ * waiting for the disk. A BatchReader keeps many reads in flight, and parses the files read on a pool of worker
+ * threads while the next ones are being read.
+ *
+ * On Linux, the files are opened and read asynchronously with io_uring, from the calling thread. Where io_uring is
+ * not available (an older kernel, a container forbidding it, another system), the files are read with pread() by
+ * a pool of I/O threads, one per read in flight.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * BatchReader batch;
+ * batch.parseFiles(files, [&](size_t index, BatchReader::Result& result) {
+ *     if(!result.error.empty())
+ *         report(files[index], result.error);
+ *     else
+ *         process(files[index], result.document);
+ * });
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * An error in a file (missing, unreadable, invalid syntax) doesn't stop the batch: it is given in the result of the
+ * file. The files are read entirely in memory before being parsed, so the batch is meant for many small files.
+ * \see Reader, YamlReader
+ */
+class BatchReader
+{
+    public:
+        /*! \brief Function parsing the content _input_ of the file _file_ in _result_.
+         */
+        typedef std::function<void(Variant& result, std::istream& input, const std::string& file)> Parser;
+
+        /*! \brief The document read from a file, or the error which prevented it.
+         */
+        struct Result
+        {
+            Variant document;   //!< The content of the file.
+            std::string error;  //!< The message of the error, empty if the file has been read.
+        };
+
+        /*! \brief Function receiving the result of the file at the position _index_ in the batch.
+         */
+        typedef std::function<void(size_t index, Result& result)> Callback;
+
+
+        /*! \brief Construct a batch reader.
+         *
+         * \param threadCount The number of threads parsing the files, or 0 for one per core.
+         * \param parser The function parsing a file. By default, the files with the extension .yml or .yaml are
+         * read with YamlReader, and the other files with Reader.
+         */
+        explicit BatchReader(unsigned threadCount = 0, Parser parser = Parser());
+
+        /*! \brief Set the maximum number of files being read at the same time (32 by default).
+         */
+        void setQueueDepth(unsigned depth);
+
+        /*! \brief Use io_uring when it is available (the default), or always the pool of I/O threads.
+         */
+        void setUring(bool use);
+
+        /*! \brief Check if io_uring can be used on this system.
+         */
+        static bool hasUring();
+
+        /*! \brief Parse the files _files_, and give their results in the same order.
+         */
+        std::vector<Result> parseFiles(const std::vector<std::string>& files);
+
+        /*! \brief Parse the files _files_, and give each result to _callback_ as soon as it is ready.
+         *
+         * The callback is called by the worker threads, in the order the files are parsed: it must be thread safe.
+         * The result can be moved away by the callback. The function returns when all the files are parsed.
+         * \throw The first exception thrown by the callback is forwarded, after the end of the batch. No callback
+         * is called after it.
+         */
+        void parseFiles(const std::vector<std::string>& files, Callback callback);
+
+
+
+
+    private:
+        /*! A file read, waiting to be parsed.
+         */
+        struct Job
+        {
+            size_t index;       //!< Position of the file in the batch.
+            std::string text;   //!< Content of the file.
+            std::string error;  //!< The error while reading the file, if any.
+        };
+
+        unsigned threadCount;                   //!< Number of parsing threads.
+        unsigned queueDepth;                    //!< Number of reads in flight.
+        bool useUring;                          //!< io_uring is used when available.
+        Parser parser;                          //!< The function parsing a file.
+
+        // state of the current batch
+        const std::vector<std::string>* files;  //!< The files of the batch.
+        Callback callback;                      //!< The receiver of the results.
+        std::mutex mutex;                       //!< Protects the jobs and the state below.
+        std::condition_variable jobReady;       //!< Wakes up the workers.
+        std::condition_variable jobTaken;       //!< Wakes up the readers blocked by a full queue.
+        std::deque<Job> jobs;                   //!< The files read, not parsed yet.
+        size_t jobCapacity;                     //!< Maximum number of files read in advance.
+        bool readEnded;                         //!< All the files have been read.
+        bool stopped;                           //!< The callback has thrown: the batch stops.
+        std::exception_ptr error;               //!< The exception thrown by the callback.
+
+
+        /*! Queue a file read, waiting while the queue is full.
+         */
+        void push(Job&& job);
+
+        /*! Loop of the parsing threads.
+         */
+        void parseJobs();
+
+        /*! Read the files with io_uring. Return false if io_uring can't be used.
+         */
+        bool readWithUring();
+
+        /*! Read the files with a pool of threads.
+         */
+        void readWithThreads();
+
+        /*! Check if the batch has been stopped.
+         */
+        bool isStopped();
+
+        BatchReader(const BatchReader&) = delete;
+        BatchReader& operator= (const BatchReader&) = delete;
+};
+
+#endif // BATCHREADER_H
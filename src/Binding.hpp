@@ -0,0 +1,59 @@
+#ifndef BINDING_H
+#define BINDING_H
+
+/*! \brief Description of the fields of a C++ structure.
+ *
+ * A structure is bound by a specialization of Binding, written with the macros BINDING_BEGIN, BINDING_FIELD,
+ * BINDING_NAMED_FIELD and BINDING_END, at global scope:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * struct Point
+ * {
+ *     int x;
+ *     int y;
+ *     std::string label;
+ * };
+ *
+ * BINDING_BEGIN(Point)
+ *     BINDING_FIELD(x)
+ *     BINDING_FIELD(y)
+ *     BINDING_NAMED_FIELD("name", label)
+ * BINDING_END()
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The specialization provides the static method <em>fields(visitor, object)</em>, calling
+ * <em>visitor(key, object.field)</em> for each field in the declaration order. The object can be const.
+ * The visitors are provided by ObjectReader and ObjectWriter.
+ * \see ObjectReader, ObjectWriter
+ */
+template<class T>
+struct Binding;
+
+
+/*! \brief Start the binding of the structure _Type_.
+ */
+#define BINDING_BEGIN(Type) \
+    template<> \
+    struct Binding<Type> \
+    { \
+        template<class Visitor, class Object> \
+        static void fields(Visitor& visitor, Object& object) \
+        {
+
+/*! \brief Bind the field _name_ to the key of the same name.
+ */
+#define BINDING_FIELD(name) \
+            visitor(#name, object.name);
+
+/*! \brief Bind the field _name_ to the key _key_.
+ */
+#define BINDING_NAMED_FIELD(key, name) \
+            visitor(key, object.name);
+
+/*! \brief End the binding started with BINDING_BEGIN.
+ */
+#define BINDING_END() \
+        } \
+    };
+
+#endif // BINDING_H
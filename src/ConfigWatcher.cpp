@@ -0,0 +1,182 @@
+#include "ConfigWatcher.hpp"
+#include "Reader.hpp"
+#include "YamlReader.hpp"
+#include <stdexcept>
+#include <cctype>
+
+namespace
+{
+    const int maxAttempts = 3; //!< Number of reads of a file modified during its parsing, before giving up.
+
+    /*! Get the reader slot of the calling thread. The threads are spread on the slots in their creation order.
+     */
+    size_t threadSlot(size_t slotCount)
+    {
+        static std::atomic<size_t> nextThread(0);
+        thread_local size_t slot = nextThread.fetch_add(1, std::memory_order_relaxed);
+        return slot % slotCount;
+    }
+}
+
+
+//******************************** Snapshot *******************************//
+ConfigWatcher::Snapshot& ConfigWatcher::Snapshot::operator= (Snapshot&& s) noexcept
+{
+    if(this != &s)
+    {
+        release();
+        doc = s.doc;
+        counter = s.counter;
+        s.counter = 0;
+    }
+    return *this;
+}
+
+
+//******************************** Constructors *******************************//
+ConfigWatcher::ConfigWatcher(const std::string& file, std::chrono::milliseconds interval, Parser parser) :
+    file(file),
+    interval(interval),
+    parser(parser),
+    current(0),
+    epoch(0),
+    version(0),
+    fileSize(0),
+    stopping(false)
+{
+    if(!this->parser)
+    {
+        std::string extension = std::filesystem::path(file).extension().string();
+        for(size_t i = 0; i < extension.size(); i++)
+            extension[i] = std::tolower(static_cast<unsigned char>(extension[i]));
+        if(extension == ".yml" || extension == ".yaml")
+            this->parser = &YamlReader::parseFile;
+        else
+            this->parser = &Reader::parseFile;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        load();
+    }
+    watcher = std::thread(&ConfigWatcher::watch, this);
+}
+
+ConfigWatcher::~ConfigWatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        stopping = true;
+    }
+    stopCondition.notify_all();
+    watcher.join();
+    delete current.load();
+}
+
+
+//****************************** Public functions *******************************//
+ConfigWatcher::Snapshot ConfigWatcher::read() const
+{
+    // the counter is incremented before loading the document, so a reload publishing a new document after
+    // this increment waits for the snapshot before freeing the previous one
+    ReaderSlot& slot = slots[threadSlot(slotCount)];
+    std::atomic<long>* counter = &slot.active[epoch.load(std::memory_order_acquire) & 1];
+    counter->fetch_add(1, std::memory_order_seq_cst);
+    return Snapshot(current.load(std::memory_order_seq_cst), counter);
+}
+
+bool ConfigWatcher::reload()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    try {
+        load();
+    } catch(std::exception& e) {
+        error = e.what();
+        return false;
+    }
+    return true;
+}
+
+unsigned long ConfigWatcher::getVersion() const {
+    return version.load(); }
+
+std::string ConfigWatcher::getError() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return error;
+}
+
+
+//****************************** Private functions *******************************//
+void ConfigWatcher::load()
+{
+    Variant root;
+    for(int attempt = 1; ; attempt++)
+    {
+        // the time is read before parsing, so a modification during the parsing is seen
+        std::error_code ec;
+        modified = std::filesystem::last_write_time(file, ec);
+        fileSize = std::filesystem::file_size(file, ec);
+
+        parser(root, file);
+
+        if(!current.load() || (std::filesystem::last_write_time(file, ec) == modified &&
+                               std::filesystem::file_size(file, ec) == fileSize))
+            break;
+        if(attempt == maxAttempts)
+        {
+            // still being written: read again at the next check
+            modified = std::filesystem::file_time_type::min();
+            throw std::runtime_error("ConfigWatcher::load : the file is modified while it is read");
+        }
+    }
+
+    const FrozenDocument* doc = new FrozenDocument(FrozenDocument::freeze(root));
+
+    const FrozenDocument* previous = current.exchange(doc, std::memory_order_seq_cst);
+    version.fetch_add(1);
+    error.clear();
+    if(previous)
+    {
+        synchronize();
+        delete previous;
+    }
+}
+
+void ConfigWatcher::watch()
+{
+    std::unique_lock<std::mutex> lock(stopMutex);
+    while(!stopCondition.wait_for(lock, interval, [this]{ return stopping; }))
+    {
+        lock.unlock();
+        if(changed())
+            reload();
+        lock.lock();
+    }
+}
+
+bool ConfigWatcher::changed()
+{
+    std::error_code ec;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(file, ec);
+    if(ec)
+        return false;
+    uintmax_t size = std::filesystem::file_size(file, ec);
+    if(ec)
+        return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return time != modified || size != fileSize;
+}
+
+void ConfigWatcher::synchronize()
+{
+    // a reader counted in any of the two epochs can hold the previous document: wait for both
+    for(int phase = 0; phase < 2; phase++)
+    {
+        unsigned long previous = epoch.fetch_add(1, std::memory_order_seq_cst);
+        for(size_t i = 0; i < slotCount; i++)
+            while(slots[i].active[previous & 1].load(std::memory_order_seq_cst) != 0)
+                std::this_thread::yield();
+    }
+}
@@ -0,0 +1,184 @@
+#ifndef CONFIGWATCHER_H
+#define CONFIGWATCHER_H
+
+#include "FrozenDocument.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/*! \brief Class reloading a configuration file in the background, and publishing it to the reader threads
+ * without locks.
+ *
+ * A thread checks the modification time of the file at a regular interval. When it changes, the file is parsed
+ * and frozen in a FrozenDocument (see FrozenDocument), then published atomically. The request threads never wait
+ * for a reload: read() only increments a counter and loads a pointer.
+ *
+ * The previous document is freed once no reader uses it anymore. The readers are counted by epoch: read() adds
+ * the reader to the counter of the current epoch. A reload publishes the new document, then moves twice to the
+ * next epoch, waiting each time for the readers of the previous epoch to leave. The counters are spread on many
+ * cache lines, so the readers of different threads don't share them.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * ConfigWatcher config("routes.yml", std::chrono::seconds(2));
+ * // in each request thread
+ * ConfigWatcher::Snapshot snapshot = config.read();
+ * FrozenValue target = snapshot.getRoot()["routes"][path]["target"];
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * A snapshot keeps its document alive, so it should be released quickly: the next reload waits for it.
+ * If the new content can't be parsed, the previous document is kept and the error is available with getError().
+ * A file modified during its parsing is read again, a few times, before the reload fails: it is then not published,
+ * and is read again at the next check. The file should still be replaced atomically (written to a temporary file,
+ * then renamed), so a partial file is never read.
+ * \see FrozenDocument
+ */
+class ConfigWatcher
+{
+    public:
+        /*! \brief Function parsing the file _file_ in _result_.
+         */
+        typedef std::function<void(Variant& result, const std::string& file)> Parser;
+
+        /*! \brief A document published by a ConfigWatcher, kept alive while the snapshot exists.
+         *
+         * A snapshot must not be used after the destruction of its watcher.
+         */
+        class Snapshot
+        {
+            public:
+                Snapshot(Snapshot&& s) noexcept : doc(s.doc), counter(s.counter) {
+                    s.counter = 0; }
+
+                ~Snapshot() {
+                    release(); }
+
+                Snapshot& operator= (Snapshot&& s) noexcept;
+
+                /*! \brief Get the root of the document.
+                 */
+                FrozenValue getRoot() const {
+                    return doc->getRoot(); }
+
+                /*! \brief Get the document.
+                 */
+                const FrozenDocument& getDocument() const {
+                    return *doc; }
+
+            private:
+                const FrozenDocument* doc;      //!< The document.
+                std::atomic<long>* counter;     //!< The counter of readers to decrement, or null.
+
+                Snapshot(const FrozenDocument* doc, std::atomic<long>* counter) : doc(doc), counter(counter) {}
+
+                void release()
+                {
+                    if(counter)
+                        counter->fetch_sub(1, std::memory_order_release);
+                    counter = 0;
+                }
+
+                Snapshot(const Snapshot&) = delete;
+                Snapshot& operator= (const Snapshot&) = delete;
+
+                friend class ConfigWatcher;
+        };
+
+
+        /*! \brief Load the file _file_ and start watching it.
+         *
+         * \param file The configuration file.
+         * \param interval The interval between two checks of the modification time.
+         * \param parser The function parsing the file. By default, the files with the extension .yml or .yaml are
+         * read with YamlReader, and the other files with Reader.
+         * \throw std::invalid_argument is thrown if the file cannot be read. The exceptions of the parser are
+         * also forwarded.
+         */
+        ConfigWatcher(const std::string& file, std::chrono::milliseconds interval = std::chrono::seconds(1),
+                      Parser parser = Parser());
+
+        /*! \brief Stop watching the file.
+         *
+         * There must be no snapshot left.
+         */
+        ~ConfigWatcher();
+
+        /*! \brief Get the current document. This never blocks.
+         */
+        Snapshot read() const;
+
+        /*! \brief Parse the file now and publish it, whatever its modification time.
+         *
+         * \return false if the file can't be parsed, or is still modified after a few reads. The previous document
+         * is then kept and the error is available with getError().
+         */
+        bool reload();
+
+        /*! \brief Get the number of documents published, including the first one.
+         */
+        unsigned long getVersion() const;
+
+        /*! \brief Get the error of the last reload, or an empty string if it succeeded.
+         */
+        std::string getError() const;
+
+
+
+
+    private:
+        /*! Counters of the readers of the two last epochs, on its own cache line.
+         */
+        struct alignas(64) ReaderSlot
+        {
+            std::atomic<long> active[2];
+
+            ReaderSlot() {
+                active[0] = 0; active[1] = 0; }
+        };
+
+        static const size_t slotCount = 32;             //!< Number of reader slots.
+
+        std::string file;                               //!< The configuration file.
+        std::chrono::milliseconds interval;             //!< Interval between two checks.
+        Parser parser;                                  //!< The function parsing the file.
+        std::atomic<const FrozenDocument*> current;     //!< The published document.
+        std::atomic<unsigned long> epoch;               //!< The current epoch.
+        std::atomic<unsigned long> version;             //!< Number of documents published.
+        mutable ReaderSlot slots[slotCount];            //!< The readers counters.
+
+        mutable std::mutex mutex;                       //!< Serializes the reloads and protects error.
+        std::string error;                              //!< The error of the last reload.
+        std::filesystem::file_time_type modified;       //!< Modification time of the file last read.
+        uintmax_t fileSize;                             //!< Size of the file last read.
+
+        std::mutex stopMutex;                           //!< Protects stopping.
+        std::condition_variable stopCondition;          //!< Wakes up the thread to stop it.
+        bool stopping;                                  //!< The thread must stop.
+        std::thread watcher;                            //!< The thread watching the file.
+
+
+        /*! Parse the file and publish it. Called with _mutex_ locked.
+         */
+        void load();
+
+        /*! Loop of the watching thread.
+         */
+        void watch();
+
+        /*! Check if the file has been modified since the last read.
+         */
+        bool changed();
+
+        /*! Wait until no reader uses the documents published before the last one.
+         */
+        void synchronize();
+
+        ConfigWatcher(const ConfigWatcher&) = delete;
+        ConfigWatcher& operator= (const ConfigWatcher&) = delete;
+};
+
+#endif // CONFIGWATCHER_H
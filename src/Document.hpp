@@ -0,0 +1,154 @@
+#ifndef DOCUMENT_H
+#define DOCUMENT_H
+
+#include "Reader.hpp"
+#include "VariantPool.hpp"
+#include <istream>
+#include <fstream>
+#include <streambuf>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+/*! \brief Class parsing documents one after the other, reusing its reader, its buffers and the storage of the
+ * previous document.
+ *
+ * The static methods Reader::parseString() and Reader::parseFile() construct a new reader for each call, and the
+ * previous result is freed node by node before the next one is built. A BasicDocument keeps its reader (with its
+ * buffers and its table of keys) and a VariantPool: reset() gives the previous tree to the pool, and the next parse
+ * takes its strings, arrays, maps, packed arrays, shaped maps and shapes from it. A text is read in place, without
+ * copying it in a stream. Once the pool has the storage of a document, a document with the same structure is parsed
+ * without any allocation (a longer string or a larger array still grows its storage).
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * JsonDocument doc;
+ * while(Request* request = nextRequest())
+ * {
+ *     const Variant& body = doc.parseString(request->body);
+ *     process(body);
+ * }
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The root of the document is valid until the next parse or reset().
+ * \note A BasicDocument is not thread safe, each thread must use its own document.
+ * \see BasicReader, VariantPool
+ */
+template<class Dialect>
+class BasicDocument
+{
+    public:
+        /*! \brief Construct an empty document.
+         *
+         * \param maxObjects The maximum number of objects of each kind kept by the pool (see VariantPool).
+         */
+        explicit BasicDocument(size_t maxObjects = 65536) :
+            input(&buffer),
+            reader(&input),
+            pool(maxObjects)
+        {
+            reader.setPool(&pool);
+        }
+
+        /*! \brief Parse _text_ in the root of the document.
+         *
+         * The previous content of the document is released first.
+         * \return The root of the document.
+         */
+        Variant& parseString(std::string_view text)
+        {
+            reset();
+            buffer.set(text.data(), text.size());
+            input.clear();
+            reader.setStream(&input);
+            reader.parse(root);
+            return root;
+        }
+
+        /*! \brief Parse the file _file_ in the root of the document.
+         *
+         * The previous content of the document is released first.
+         * \return The root of the document.
+         * \throw std::invalid_argument is thown if the the file cannot be opened.
+         */
+        Variant& parseFile(const std::string& file)
+        {
+            std::ifstream strm(file.c_str());
+            if(!strm.is_open())
+                throw std::invalid_argument("BasicDocument::parseFile : Cannot open file");
+            reset();
+            reader.setStream(&strm);
+            try {
+                reader.parse(root);
+            } catch(...) {
+                detachFile();
+                throw;
+            }
+            detachFile();
+            return root;
+        }
+
+        /*! \brief Release the content of the document to its pool. The root is then null.
+         */
+        void reset() {
+            pool.release(root); }
+
+        /*! \brief Get the root of the document.
+         */
+        Variant& getRoot() {
+            return root; }
+
+        /*! \brief Get the root of the document.
+         */
+        const Variant& getRoot() const {
+            return root; }
+
+        /*! \brief Get the reader of the document, to set its options.
+         * \note The pool of the reader must not be changed.
+         */
+        BasicReader<Dialect>& getReader() {
+            return reader; }
+
+        /*! \brief Get the pool keeping the storage of the released documents.
+         */
+        VariantPool& getPool() {
+            return pool; }
+
+
+
+
+    private:
+        /*! Stream buffer reading a text in place.
+         */
+        struct TextBuffer : public std::streambuf
+        {
+            void set(const char* text, size_t size)
+            {
+                char* begin = const_cast<char*>(text);
+                setg(begin, begin, begin + size);
+            }
+        };
+
+        TextBuffer buffer;              //!< The buffer on the text parsed.
+        std::istream input;             //!< The stream on the buffer.
+        BasicReader<Dialect> reader;    //!< The reader, kept with its buffers between the documents.
+        VariantPool pool;               //!< The storage of the released documents.
+        Variant root;                   //!< The root of the document.
+
+        /*! Set the reader back on the text stream, so it doesn't keep a pointer on a closed file.
+         */
+        void detachFile()
+        {
+            input.clear();
+            reader.setStream(&input);
+        }
+
+        BasicDocument(const BasicDocument&) = delete;
+        BasicDocument& operator= (const BasicDocument&) = delete;
+};
+
+typedef BasicDocument<RelaxedDialect> Document;         //!< Document of the relaxed syntax.
+typedef BasicDocument<StrictJsonDialect> JsonDocument;  //!< Document of strict JSON.
+typedef BasicDocument<Json5Dialect> Json5Document;      //!< Document of JSON5.
+typedef BasicDocument<HoconDialect> HoconDocument;      //!< Document of a HOCON like syntax.
+
+#endif // DOCUMENT_H
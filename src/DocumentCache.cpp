@@ -0,0 +1,215 @@
+#include "DocumentCache.hpp"
+#include "Reader.hpp"
+#include "YamlReader.hpp"
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    const uint64_t prime1 = 0x9E3779B97F4A7C15ULL;
+    const uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+
+    inline uint64_t rotate(uint64_t x, int bits) {
+        return (x << bits) | (x >> (64 - bits)); }
+
+    inline uint64_t mixWord(uint64_t h, uint64_t word) {
+        return rotate(h ^ rotate(word * prime2, 31) * prime1, 27) * prime1 + prime2; }
+
+    /*! Spread the bits of the hash, so the close contents have unrelated hashes.
+     */
+    inline uint64_t finalize(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    /*! Parse _text_ with the reader of _syntax_.
+     */
+    void parseText(Variant& result, std::string_view text, DocumentCache::Syntax syntax)
+    {
+        std::istringstream strm(std::string(text), std::istringstream::in | std::istringstream::binary);
+        switch(syntax)
+        {
+            case DocumentCache::JSON:
+                {
+                    JsonReader reader(&strm);
+                    reader.parse(result);
+                }
+                break;
+            case DocumentCache::JSON5:
+                {
+                    Json5Reader reader(&strm);
+                    reader.parse(result);
+                }
+                break;
+            case DocumentCache::HOCON:
+                {
+                    HoconReader reader(&strm);
+                    reader.parse(result);
+                }
+                break;
+            case DocumentCache::YAML:
+                {
+                    YamlReader reader(&strm);
+                    reader.parse(result);
+                }
+                break;
+            default:
+                {
+                    Reader reader(&strm);
+                    reader.parse(result);
+                }
+                break;
+        }
+    }
+}
+
+
+//******************************** Constructors *******************************//
+DocumentCache::DocumentCache(size_t capacity) :
+    capacity(capacity),
+    usage(0),
+    hits(0),
+    misses(0)
+{}
+
+
+//****************************** Public functions *******************************//
+std::shared_ptr<const FrozenDocument> DocumentCache::parseString(std::string_view text, Syntax syntax)
+{
+    if(syntax == AUTO)
+        syntax = RELAXED;
+    ContentKey key = { hash(text), text.size(), syntax };
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::unordered_map<ContentKey,EntryList::iterator,KeyHash>::iterator it = index.find(key);
+        if(it != index.end() && it->second->content == text)
+        {
+            hits++;
+            entries.splice(entries.begin(), entries, it->second);
+            return it->second->doc;
+        }
+        misses++;
+    }
+
+    // the content is parsed without the lock, so the other threads are not blocked
+    Variant root;
+    parseText(root, text, syntax);
+    std::shared_ptr<const FrozenDocument> doc = std::make_shared<FrozenDocument>(FrozenDocument::freeze(root));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if(doc->imageSize() + text.size() > capacity || index.count(key))
+        return doc; // too large to be kept, parsed by another thread meanwhile, or another content with this key
+    shrink(capacity - doc->imageSize() - text.size());
+    entries.push_front(Entry{ key, doc, std::string(text) });
+    index.emplace(key, entries.begin());
+    usage += entries.front().memoryUsage();
+    return doc;
+}
+
+std::shared_ptr<const FrozenDocument> DocumentCache::parseFile(const std::string& file, Syntax syntax)
+{
+    if(syntax == AUTO)
+    {
+        std::string extension = std::filesystem::path(file).extension().string();
+        for(size_t i = 0; i < extension.size(); i++)
+            extension[i] = std::tolower(static_cast<unsigned char>(extension[i]));
+        syntax = extension == ".yml" || extension == ".yaml" ? YAML : RELAXED;
+    }
+
+    std::ifstream strm(file.c_str(), std::ifstream::in | std::ifstream::binary);
+    if(!strm.is_open())
+        throw std::invalid_argument("DocumentCache::parseFile : Cannot open file");
+    std::string content((std::istreambuf_iterator<char>(strm)), std::istreambuf_iterator<char>());
+    return parseString(content, syntax);
+}
+
+void DocumentCache::setCapacity(size_t size)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    capacity = size;
+    shrink(capacity);
+}
+
+size_t DocumentCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+size_t DocumentCache::memoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return usage;
+}
+
+unsigned long DocumentCache::getHits() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+}
+
+unsigned long DocumentCache::getMisses() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+}
+
+void DocumentCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    shrink(0);
+}
+
+uint64_t DocumentCache::hash(std::string_view text)
+{
+    // four independent lanes of 8 bytes, so the multiplications of a block run in parallel
+    const char* p = text.data();
+    const char* end = p + text.size();
+    uint64_t h = text.size() * prime1;
+    if(text.size() >= 32)
+    {
+        uint64_t lanes[4] = { h + prime1 + prime2, h + prime2, h, h - prime1 };
+        for(; end - p >= 32; p += 32)
+        {
+            uint64_t words[4];
+            std::memcpy(words, p, sizeof(words));
+            for(int i = 0; i < 4; i++)
+                lanes[i] = mixWord(lanes[i], words[i]);
+        }
+        h = rotate(lanes[0], 1) + rotate(lanes[1], 7) + rotate(lanes[2], 12) + rotate(lanes[3], 18);
+    }
+    for(; end - p >= 8; p += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        h = mixWord(h, word);
+    }
+    if(p < end)
+    {
+        uint64_t word = 0;
+        std::memcpy(&word, p, end - p);
+        h = mixWord(h, word);
+    }
+    return finalize(h);
+}
+
+
+//****************************** Private functions *******************************//
+void DocumentCache::shrink(size_t limit)
+{
+    while(usage > limit && !entries.empty())
+    {
+        usage -= entries.back().memoryUsage();
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+}
@@ -0,0 +1,152 @@
+#ifndef DOCUMENTCACHE_H
+#define DOCUMENTCACHE_H
+
+#include "FrozenDocument.hpp"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/*! \brief Cache of the documents parsed, found by the hash of their content.
+ *
+ * Services often parse the same payloads again and again (templates, default configurations...). A DocumentCache
+ * hashes the input with a fast non-cryptographic hash, and returns the document parsed the last time the same
+ * content was given, without parsing it. The documents are frozen (see FrozenDocument), so a single copy is
+ * shared by all the threads:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * DocumentCache cache(256 << 20);
+ * // in each worker thread
+ * std::shared_ptr<const FrozenDocument> doc = cache.parseString(payload, DocumentCache::JSON);
+ * FrozenValue name = doc->getRoot()["name"];
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The memory used by the documents is bounded: the least recently used ones are dropped when the limit is
+ * reached. A document dropped stays valid while it is used. The methods are thread safe, and the parsing is done
+ * without holding the lock.
+ *
+ * The contents are found by their size and a 64 bits hash, then compared with the content of the document found:
+ * each document keeps a copy of its content, counted in the memory used. Two contents with the same hash are
+ * both parsed, and only the first one is kept.
+ * \see FrozenDocument, ConfigWatcher
+ */
+class DocumentCache
+{
+    public:
+        /*! \brief The syntax of a content, part of its key in the cache.
+         */
+        enum Syntax {
+            AUTO,       //!< YAML for the files with the extension .yml or .yaml, RELAXED otherwise.
+            RELAXED,    //!< Read with Reader.
+            JSON,       //!< Read with JsonReader.
+            JSON5,      //!< Read with Json5Reader.
+            HOCON,      //!< Read with HoconReader.
+            YAML        //!< Read with YamlReader (the first document).
+        };
+
+        /*! \brief Construct an empty cache.
+         *
+         * \param capacity The maximum size of the images and the contents of the documents kept, in bytes.
+         */
+        explicit DocumentCache(size_t capacity = 64 << 20);
+
+        /*! \brief Parse _text_, or get the document of the same content parsed before.
+         *
+         * The exceptions of the reader are forwarded, and nothing is cached in this case.
+         */
+        std::shared_ptr<const FrozenDocument> parseString(std::string_view text, Syntax syntax = AUTO);
+
+        /*! \brief Read the file _file_, and parse it or get the document of the same content parsed before.
+         *
+         * The file is always read, only its parsing is skipped.
+         * \throw std::invalid_argument is thrown if the file cannot be opened. The exceptions of the reader are
+         * also forwarded.
+         */
+        std::shared_ptr<const FrozenDocument> parseFile(const std::string& file, Syntax syntax = AUTO);
+
+        /*! \brief Set the maximum size of the images and the contents of the documents kept, dropping documents
+         * if needed.
+         */
+        void setCapacity(size_t capacity);
+
+        /*! \brief Get the number of documents kept.
+         */
+        size_t size() const;
+
+        /*! \brief Get the size of the images and the contents of the documents kept, in bytes.
+         */
+        size_t memoryUsage() const;
+
+        /*! \brief Get the number of contents found in the cache.
+         */
+        unsigned long getHits() const;
+
+        /*! \brief Get the number of contents parsed.
+         */
+        unsigned long getMisses() const;
+
+        /*! \brief Drop all the documents.
+         */
+        void clear();
+
+        /*! \brief Compute the hash of _text_ used by the cache.
+         */
+        static uint64_t hash(std::string_view text);
+
+
+
+
+    private:
+        /*! Identity of a content.
+         */
+        struct ContentKey
+        {
+            uint64_t hash;
+            uint64_t size;
+            Syntax syntax;
+
+            bool operator== (const ContentKey& k) const {
+                return hash == k.hash && size == k.size && syntax == k.syntax; }
+        };
+
+        struct KeyHash
+        {
+            size_t operator() (const ContentKey& k) const {
+                return static_cast<size_t>(k.hash ^ (k.size * 0x9E3779B97F4A7C15ULL) ^ k.syntax); }
+        };
+
+        /*! A document kept, in the list of the recently used documents.
+         */
+        struct Entry
+        {
+            ContentKey key;
+            std::shared_ptr<const FrozenDocument> doc;
+            std::string content;    //!< The content parsed, compared with the contents of the same key.
+
+            size_t memoryUsage() const {
+                return doc->imageSize() + content.size(); }
+        };
+
+        typedef std::list<Entry> EntryList;
+
+        size_t capacity;                                                        //!< Maximum size of the documents kept.
+        size_t usage;                                                           //!< Size of the documents kept.
+        unsigned long hits;                                                     //!< Number of contents found.
+        unsigned long misses;                                                   //!< Number of contents parsed.
+        EntryList entries;                                                      //!< The documents, most recent first.
+        std::unordered_map<ContentKey,EntryList::iterator,KeyHash> index;       //!< The documents by key.
+        mutable std::mutex mutex;                                               //!< Protects all the members.
+
+
+        /*! Drop the least recently used documents until the usage is below _limit_. Called with _mutex_ locked.
+         */
+        void shrink(size_t limit);
+
+        DocumentCache(const DocumentCache&) = delete;
+        DocumentCache& operator= (const DocumentCache&) = delete;
+};
+
+#endif // DOCUMENTCACHE_H
@@ -0,0 +1,380 @@
+#include "Encoding.hpp"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const unsigned int replacement = 0xFFFD;    //!< The replacement character, for the invalid code units.
+
+inline unsigned int readUnit16(const char* in, bool bigEndian)
+{
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(in);
+    return bigEndian ? (b[0] << 8 | b[1]) : (b[1] << 8 | b[0]);
+}
+
+inline uint32_t readUnit32(const char* in, bool bigEndian)
+{
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(in);
+    if(bigEndian)
+        return static_cast<uint32_t>(b[0]) << 24 | b[1] << 16 | b[2] << 8 | b[3];
+    return static_cast<uint32_t>(b[3]) << 24 | b[2] << 16 | b[1] << 8 | b[0];
+}
+
+#ifdef __SSE2__
+/*! Convert the ASCII characters at the start of [in, end), 16 at a time. Stop at the first block containing
+ *  another character, which is left to the scalar conversion.
+ */
+inline void convertAscii16(const char*& in, const char* end, char*& out, bool bigEndian)
+{
+    // a big endian unit is read byte-swapped: the character is in the high byte
+    const __m128i mask = _mm_set1_epi16(static_cast<short>(bigEndian ? 0x80FF : 0xFF80));
+    const __m128i shift = _mm_cvtsi32_si128(bigEndian ? 8 : 0);
+    const __m128i zero = _mm_setzero_si128();
+    while(end - in >= 32)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16));
+        __m128i invalid = _mm_and_si128(_mm_or_si128(a, b), mask);
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, zero)) != 0xFFFF)
+            break;
+        __m128i chars = _mm_packus_epi16(_mm_srl_epi16(a, shift), _mm_srl_epi16(b, shift));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), chars);
+        in += 32;
+        out += 16;
+    }
+}
+
+/*! \see convertAscii16()
+ */
+inline void convertAscii32(const char*& in, const char* end, char*& out, bool bigEndian)
+{
+    const __m128i mask = _mm_set1_epi32(static_cast<int>(bigEndian ? 0x80FFFFFF : 0xFFFFFF80));
+    const __m128i shift = _mm_cvtsi32_si128(bigEndian ? 24 : 0);
+    const __m128i zero = _mm_setzero_si128();
+    while(end - in >= 64)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 32));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 48));
+        __m128i invalid = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), mask);
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, zero)) != 0xFFFF)
+            break;
+        __m128i low = _mm_packs_epi32(_mm_srl_epi32(a, shift), _mm_srl_epi32(b, shift));
+        __m128i high = _mm_packs_epi32(_mm_srl_epi32(c, shift), _mm_srl_epi32(d, shift));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(low, high));
+        in += 64;
+        out += 16;
+    }
+}
+#endif
+
+/*! Check the UTF-8 sequence starting at _b_, with _available_ bytes readable.
+ *  Overlong forms, surrogates and code points above U+10FFFF are rejected.
+ *  \return The length of the sequence, 0 if it is invalid, or -1 if it is valid but incomplete.
+ */
+inline int checkUtf8(const unsigned char* b, size_t available)
+{
+    unsigned char c = b[0];
+    if(c < 0x80)
+        return 1;
+
+    int length;
+    unsigned char low = 0x80, high = 0xBF; // range of the second byte
+    if(c >= 0xC2 && c <= 0xDF)
+        length = 2;
+    else if(c >= 0xE0 && c <= 0xEF)
+    {
+        length = 3;
+        if(c == 0xE0)
+            low = 0xA0;
+        else if(c == 0xED)
+            high = 0x9F;
+    }
+    else if(c >= 0xF0 && c <= 0xF4)
+    {
+        length = 4;
+        if(c == 0xF0)
+            low = 0x90;
+        else if(c == 0xF4)
+            high = 0x8F;
+    }
+    else
+        return 0;
+
+    for(int i = 1; i < length; i++)
+    {
+        if(static_cast<size_t>(i) >= available)
+            return -1;
+        if(b[i] < low || b[i] > high)
+            return 0;
+        low = 0x80;
+        high = 0xBF;
+    }
+    return length;
+}
+
+/*! Copy [in, end) to _out_ while validating it. Stop at the first invalid sequence and set _invalid_.
+ */
+char* copyUtf8(const char*& in, const char* end, char* out, bool last, bool& invalid)
+{
+    while(in != end)
+    {
+#ifdef __SSE2__
+        // the ASCII characters are copied 16 at a time, the validation is then just a test of the high bits
+        while(end - in >= 16)
+        {
+            __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+            if(_mm_movemask_epi8(chars) != 0)
+                break;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), chars);
+            in += 16;
+            out += 16;
+        }
+        if(in == end)
+            break;
+#endif
+        int length = checkUtf8(reinterpret_cast<const unsigned char*>(in), end - in);
+        if(length < 0 && !last)
+            break; // the end of the sequence is in the next block
+        if(length <= 0)
+        {
+            invalid = true;
+            break;
+        }
+        for(int i = 0; i < length; i++)
+            *out++ = *in++;
+    }
+    return out;
+}
+
+/*! Convert [in, end) to UTF-8 in _out_, which must have room for 3 bytes per 2 input bytes, plus 3.
+ *  _in_ is moved after the last unit converted. If _last_ is false, an incomplete unit or surrogate pair at the
+ *  end is left for the next call.
+ *  An invalid unit is replaced by U+FFFD if _invalid_ is null. Otherwise the conversion stops at the unit and
+ *  _invalid_ is set, and a UTF-8 input is validated.
+ *  \return The end of the output.
+ */
+char* convert(const char*& in, const char* end, Encoding encoding, char* out, bool last, bool* invalid)
+{
+    if(encoding == UTF8)
+    {
+        if(invalid)
+            return copyUtf8(in, end, out, last, *invalid);
+        std::memcpy(out, in, end - in);
+        out += end - in;
+        in = end;
+        return out;
+    }
+
+    bool bigEndian = encoding == UTF16_BE || encoding == UTF32_BE;
+    if(encoding == UTF16_LE || encoding == UTF16_BE)
+    {
+        while(end - in >= 2)
+        {
+#ifdef __SSE2__
+            convertAscii16(in, end, out, bigEndian);
+            if(end - in < 2)
+                break;
+#endif
+            unsigned int c = readUnit16(in, bigEndian);
+            size_t length = 2;
+            if(c >= 0xD800 && c <= 0xDBFF)
+            {
+                if(end - in < 4 && !last)
+                    break; // the low surrogate is in the next block
+                unsigned int low = end - in >= 4 ? readUnit16(in + 2, bigEndian) : 0;
+                if(low >= 0xDC00 && low <= 0xDFFF)
+                {
+                    c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                    length = 4;
+                }
+                else
+                    c = replacement;
+            }
+            else if(c >= 0xDC00 && c <= 0xDFFF)
+                c = replacement;
+
+            if(c == replacement && invalid)
+            {
+                *invalid = true;
+                return out;
+            }
+            in += length;
+            out = encodeUtf8(out, c);
+        }
+    }
+    else
+    {
+        while(end - in >= 4)
+        {
+#ifdef __SSE2__
+            convertAscii32(in, end, out, bigEndian);
+            if(end - in < 4)
+                break;
+#endif
+            uint32_t c = readUnit32(in, bigEndian);
+            if(c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+            {
+                if(invalid)
+                {
+                    *invalid = true;
+                    return out;
+                }
+                c = replacement;
+            }
+            in += 4;
+            out = encodeUtf8(out, c);
+        }
+    }
+
+    if(last && in != end)
+    {
+        if(invalid)
+        {
+            *invalid = true;
+            return out;
+        }
+        out = encodeUtf8(out, replacement);
+        in = end;
+    }
+    return out;
+}
+
+}
+
+
+Encoding detectEncoding(const unsigned char* bytes, size_t size, size_t& bomSize)
+{
+    bomSize = 0;
+    if(size >= 4 && bytes[0] == 0x00 && bytes[1] == 0x00 && bytes[2] == 0xFE && bytes[3] == 0xFF)
+    {
+        bomSize = 4;
+        return UTF32_BE;
+    }
+    if(size >= 4 && bytes[0] == 0xFF && bytes[1] == 0xFE && bytes[2] == 0x00 && bytes[3] == 0x00)
+    {
+        bomSize = 4;
+        return UTF32_LE;
+    }
+    if(size >= 2 && bytes[0] == 0xFE && bytes[1] == 0xFF)
+    {
+        bomSize = 2;
+        return UTF16_BE;
+    }
+    if(size >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE)
+    {
+        bomSize = 2;
+        return UTF16_LE;
+    }
+    if(size >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF)
+    {
+        bomSize = 3;
+        return UTF8;
+    }
+
+    if(size >= 4 && bytes[0] == 0x00 && bytes[1] == 0x00 && bytes[2] == 0x00)
+        return UTF32_BE;
+    if(size >= 4 && bytes[1] == 0x00 && bytes[2] == 0x00 && bytes[3] == 0x00)
+        return UTF32_LE;
+    if(size >= 2 && bytes[0] == 0x00)
+        return UTF16_BE;
+    if(size >= 2 && bytes[1] == 0x00)
+        return UTF16_LE;
+    return UTF8;
+}
+
+
+//******************************** Constructors *******************************//
+TranscodingBuffer::TranscodingBuffer(std::streambuf* source, Encoding encoding, std::string_view prefix) :
+    source(source),
+    encoding(encoding),
+    input(blockSize + prefix.size() + 4),
+    inputSize(prefix.size()),
+    output(putbackSize + input.size() / 2 * 3 + 4),
+    position(0),
+    validation(false),
+    ended(false)
+{
+    if(!prefix.empty())
+        std::memcpy(input.data(), prefix.data(), prefix.size());
+    setg(output.data(), output.data() + putbackSize, output.data() + putbackSize);
+}
+
+
+//****************************** Public functions *******************************//
+void TranscodingBuffer::setSource(std::streambuf* newSource)
+{
+    source = newSource;
+    inputSize = 0;
+    position = 0;
+    ended = false;
+    setg(output.data(), output.data() + putbackSize, output.data() + putbackSize);
+}
+
+Encoding TranscodingBuffer::getEncoding() const {
+    return encoding; }
+
+void TranscodingBuffer::setValidation(bool validate) {
+    validation = validate; }
+
+std::string TranscodingBuffer::toUtf8(std::string_view text, Encoding encoding)
+{
+    std::string result(text.size() / 2 * 3 + 4, '\0');
+    const char* in = text.data();
+    char* end = convert(in, text.data() + text.size(), encoding, &result[0], true, 0);
+    result.resize(end - result.data());
+    return result;
+}
+
+
+//****************************** Protected functions *******************************//
+TranscodingBuffer::int_type TranscodingBuffer::underflow()
+{
+    if(gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+
+    // keep the last characters before the get area, so they can be put back
+    size_t keep = gptr() - eback();
+    if(keep > putbackSize)
+        keep = putbackSize;
+    std::memmove(output.data() + putbackSize - keep, gptr() - keep, keep);
+    char* start = output.data() + putbackSize;
+
+    while(true)
+    {
+        if(!ended)
+        {
+            std::streamsize count = source->sgetn(input.data() + inputSize, input.size() - inputSize);
+            if(count > 0)
+                inputSize += static_cast<size_t>(count);
+            else
+                ended = true;
+        }
+
+        const char* in = input.data();
+        bool invalid = false;
+        char* end = convert(in, input.data() + inputSize, encoding, start, ended, validation ? &invalid : 0);
+        position += in - input.data();
+        if(invalid)
+            throw std::invalid_argument("TranscodingBuffer::underflow : invalid character at byte " +
+                                        std::to_string(position));
+        inputSize -= in - input.data();
+        std::memmove(input.data(), in, inputSize);
+
+        if(end != start)
+        {
+            setg(start - keep, start, end);
+            return traits_type::to_int_type(*start);
+        }
+        if(ended)
+        {
+            setg(start - keep, start, start);
+            return traits_type::eof();
+        }
+    }
+}
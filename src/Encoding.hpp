@@ -0,0 +1,153 @@
+#ifndef ENCODING_H
+#define ENCODING_H
+
+#include <cstdint>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*! \brief Unicode encodings of an input.
+ */
+enum Encoding {
+    UTF8,
+    UTF16_LE,
+    UTF16_BE,
+    UTF32_LE,
+    UTF32_BE
+};
+
+/*! \brief Write the code point _c_ in UTF-8 at _out_, which must have room for 4 bytes.
+ *
+ * _c_ must be at most U+10FFFF.
+ * \return The end of the sequence written.
+ */
+inline char* encodeUtf8(char* out, uint32_t c)
+{
+    if(c <= 0x7F)
+        *out++ = static_cast<char>(c);
+    else if(c <= 0x7FF)
+    {
+        *out++ = static_cast<char>(0xC0 | (c >> 6));
+        *out++ = static_cast<char>(0x80 | (c & 0x3F));
+    }
+    else if(c <= 0xFFFF)
+    {
+        *out++ = static_cast<char>(0xE0 | (c >> 12));
+        *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (c & 0x3F));
+    }
+    else
+    {
+        *out++ = static_cast<char>(0xF0 | (c >> 18));
+        *out++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (c & 0x3F));
+    }
+    return out;
+}
+
+/*! \brief Detect the encoding of a text from its first bytes.
+ *
+ * The byte order mark is used if present. Otherwise, the encoding is deduced from the null bytes, because the
+ * first character of a YAML or JSON document is ASCII:
+ *
+ * Encoding | BOM         | Without BOM
+ * -------- | ----------- | -----------
+ * UTF32_BE | 00 00 FE FF | 00 00 00 ??
+ * UTF32_LE | FF FE 00 00 | ?? 00 00 00
+ * UTF16_BE | FE FF       | 00 ??
+ * UTF16_LE | FF FE       | ?? 00
+ * UTF8     | EF BB BF    | other
+ *
+ * \param bytes The first bytes of the text.
+ * \param size The number of bytes available, only the first 4 are read.
+ * \param bomSize Set to the size of the byte order mark, 0 if there is none.
+ */
+Encoding detectEncoding(const unsigned char* bytes, size_t size, size_t& bomSize);
+
+
+/*! \brief Stream buffer converting a UTF-16 or UTF-32 input to UTF-8.
+ *
+ * The source is read in large blocks, which are converted at once in the get area of the buffer: the lexers read
+ * UTF-8 without knowing the encoding of the input, and without an extra pass on the whole text.
+ * With SSE2, the runs of ASCII characters are converted 16 at a time.
+ *
+ * The surrogate pairs are combined, even when they are split between two blocks. An invalid code unit (a lone
+ * surrogate, a code point above U+10FFFF or an incomplete unit at the end of the input) is replaced by U+FFFD.
+ * A UTF8 source is copied unchanged.
+ *
+ * With setValidation(), the input is also validated while it is converted, so an invalid document is rejected
+ * without a separate pass: each block is checked just before it is read, while it is in the cache. An invalid
+ * character then throws an exception instead of being replaced. A UTF-8 input is validated while it is copied:
+ * the overlong forms, the surrogates and the code points above U+10FFFF are rejected.
+ * The exception is forwarded by an istream only if its exception mask contains badbit.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * std::ifstream file("windows.json", std::ifstream::in | std::ifstream::binary);
+ * TranscodingBuffer buffer(file.rdbuf(), UTF16_LE);
+ * std::istream input(&buffer);
+ * Reader::parse(result, &input);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The YAML Lexer detects the encoding and installs this buffer by itself.
+ * \see detectEncoding(), Lexer
+ */
+class TranscodingBuffer : public std::streambuf
+{
+    public:
+        /*! \brief Construct a buffer reading _source_.
+         *
+         * \param source The stream buffer to read, positioned after the byte order mark.
+         * \param encoding The encoding of _source_.
+         * \param prefix Bytes already extracted from _source_, read before it.
+         */
+        TranscodingBuffer(std::streambuf* source, Encoding encoding, std::string_view prefix = std::string_view());
+
+        /*! \brief Read a new source with the same encoding. The characters of the previous source not read yet
+         *  are dropped.
+         */
+        void setSource(std::streambuf* source);
+
+        /*! \brief Get the encoding of the source.
+         */
+        Encoding getEncoding() const;
+
+        /*! \brief Enable or disable the validation of the input.
+         *
+         * The validation applies to the blocks read afterward. When it is enabled, an invalid character throws
+         * std::invalid_argument, with the offset of the character after the prefix.
+         */
+        void setValidation(bool validate);
+
+        /*! \brief Convert a whole text to UTF-8.
+         *
+         * \param text The text to convert, without byte order mark.
+         * \param encoding The encoding of _text_.
+         * \return The text in UTF-8.
+         */
+        static std::string toUtf8(std::string_view text, Encoding encoding);
+
+
+    protected:
+        int_type underflow() override;
+
+
+    private:
+        static const size_t blockSize = 65536;  //!< Number of bytes read from the source at once.
+        static const size_t putbackSize = 4;    //!< Number of characters kept before the get area for unget().
+
+        std::streambuf* source;     //!< The buffer read.
+        Encoding encoding;          //!< The encoding of the source.
+        std::vector<char> input;    //!< The bytes read and not converted yet.
+        size_t inputSize;           //!< Number of bytes in _input_.
+        std::vector<char> output;   //!< The converted characters, after the putback area.
+        size_t position;            //!< Number of bytes of the source converted.
+        bool validation;            //!< The input is validated.
+        bool ended;                 //!< The end of the source is reached.
+
+        TranscodingBuffer(const TranscodingBuffer&) = delete;
+        TranscodingBuffer& operator= (const TranscodingBuffer&) = delete;
+};
+
+#endif // ENCODING_H
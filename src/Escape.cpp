@@ -0,0 +1,148 @@
+#include "Escape.hpp"
+#include <cstring>
+
+namespace {
+
+/*! Source of an escape sequence in memory.
+ */
+struct TextSource
+{
+    const char* pos;
+    const char* end;
+
+    int get() {
+        return pos < end ? static_cast<unsigned char>(*pos++) : -1; }
+
+    int peek() {
+        return pos < end ? static_cast<unsigned char>(*pos) : -1; }
+};
+
+}
+
+
+constexpr std::array<uint32_t,256> Escape::makeSequences()
+{
+    std::array<uint32_t,256> table = {}; // LITERAL
+    const uint32_t code = static_cast<uint32_t>(CODE) << 24;
+    const uint32_t hex = static_cast<uint32_t>(HEX) << 24;
+    table['0'] = code | 0x00;
+    table['a'] = code | 0x07;
+    table['b'] = code | 0x08;
+    table['t'] = code | 0x09;
+    table['n'] = code | 0x0A;
+    table['v'] = code | 0x0B;
+    table['f'] = code | 0x0C;
+    table['r'] = code | 0x0D;
+    table['e'] = code | 0x1B;
+    table['N'] = code | 0x85;
+    table['_'] = code | 0xA0;
+    table['L'] = code | 0x2028;
+    table['P'] = code | 0x2029;
+    table['x'] = hex | 2;
+    table['u'] = hex | 4;
+    table['U'] = hex | 8;
+    return table;
+}
+
+constexpr std::array<int8_t,256> Escape::makeHexValues()
+{
+    std::array<int8_t,256> table = {};
+    for(int c = 0; c < 256; c++)
+        table[c] = -1;
+    for(int c = 0; c < 10; c++)
+        table['0' + c] = static_cast<int8_t>(c);
+    for(int c = 0; c < 6; c++)
+    {
+        table['a' + c] = static_cast<int8_t>(10 + c);
+        table['A' + c] = static_cast<int8_t>(10 + c);
+    }
+    return table;
+}
+
+const std::array<uint32_t,256> Escape::sequences = Escape::makeSequences();
+const std::array<int8_t,256> Escape::hexValues = Escape::makeHexValues();
+
+
+//****************************** Public functions *******************************//
+void Escape::decode(std::string_view text, std::string& result)
+{
+    TextSource source = { text.data(), text.data() + text.size() };
+    while(source.pos < source.end)
+    {
+        // copy the text up to the next backslash at once
+        const char* slash = static_cast<const char*>(std::memchr(source.pos, '\\', source.end - source.pos));
+        if(!slash)
+        {
+            result.append(source.pos, source.end - source.pos);
+            return;
+        }
+        result.append(source.pos, slash - source.pos);
+        source.pos = slash + 1;
+        decodeSequence(source, result);
+    }
+}
+
+bool Escape::isJson(std::string_view text)
+{
+    const char* pos = text.data();
+    const char* end = pos + text.size();
+    while(pos < end && (pos = static_cast<const char*>(std::memchr(pos, '\\', end - pos))) != 0)
+    {
+        if(++pos == end)
+            return false;
+        switch(*pos++)
+        {
+            case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+                break;
+            case 'u':
+                for(int i = 0; i < 4; i++, pos++)
+                    if(pos == end || hexValues[static_cast<unsigned char>(*pos)] < 0)
+                        return false;
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+bool Escape::isJsonNumber(std::string_view text, bool& isInteger)
+{
+    auto isDigit = [](char c) { return c >= '0' && c <= '9'; };
+    size_t i = 0, size = text.size();
+    if(i < size && text[i] == '-')
+        i++;
+    if(i == size || !isDigit(text[i]))
+        return false;
+    if(text[i++] != '0')
+        while(i < size && isDigit(text[i]))
+            i++;
+    isInteger = true;
+    if(i < size && text[i] == '.')
+    {
+        isInteger = false;
+        if(++i == size || !isDigit(text[i]))
+            return false;
+        while(i < size && isDigit(text[i]))
+            i++;
+    }
+    if(i < size && (text[i] == 'e' || text[i] == 'E'))
+    {
+        isInteger = false;
+        if(++i < size && (text[i] == '+' || text[i] == '-'))
+            i++;
+        if(i == size || !isDigit(text[i]))
+            return false;
+        while(i < size && isDigit(text[i]))
+            i++;
+    }
+    return i == size;
+}
+
+void Escape::appendUtf8(std::string& result, uint32_t c)
+{
+    if(c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+        c = 0xFFFD;
+    char buffer[4];
+    result.append(buffer, encodeUtf8(buffer, c) - buffer);
+}
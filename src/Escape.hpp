@@ -0,0 +1,144 @@
+#ifndef ESCAPE_H
+#define ESCAPE_H
+
+#include "Encoding.hpp"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*! \brief Decoder of the escape sequences of the quoted strings, shared by the JSON and YAML readers.
+ *
+ * The sequences accepted are the union of the JSON, YAML and C ones:
+ *  - <pre> \\0 \\a \\b \\t \\n \\v \\f \\r \\e </pre>: the C control characters.
+ *  - <pre> \\N \\_ \\L \\P </pre>: U+0085, U+00A0, U+2028 and U+2029 (YAML).
+ *  - <pre> \\xNN \\uNNNN \\UNNNNNNNN </pre>: a code point in hexadecimal, written in UTF-8.
+ *    A high surrogate followed by <pre> \\uNNNN </pre> with a low surrogate is decoded as a single code point.
+ *    A lone surrogate or a code point above U+10FFFF gives U+FFFD.
+ *  - any other character stands for itself: <pre> \\" \\\\ \\/ </pre>...
+ *
+ * The sequences are decoded with lookup tables, and the text between them is copied in bulk.
+ * \see Reader, Lexer
+ */
+class Escape
+{
+    public:
+        /*! \brief Decode the escape sequences of _text_ and append the result to _result_.
+         */
+        static void decode(std::string_view text, std::string& result);
+
+        /*! \brief Check that the escape sequences of _text_ are the ones of JSON.
+         *
+         * JSON only accepts <pre> \" \\ \/ \b \f \n \r \t </pre> and <pre> \uNNNN </pre> with four
+         * hexadecimal digits. The strict readers check their strings with it before decoding them.
+         * \return false if _text_ contains another sequence.
+         */
+        static bool isJson(std::string_view text);
+
+        /*! \brief Check that _text_ is a number of the JSON grammar, and set _isInteger_ if it has no fraction nor exponent.
+         *
+         * The grammar is <pre> -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)? </pre>, and the whole text must match.
+         * The strict readers check their numbers with it before converting them.
+         */
+        static bool isJsonNumber(std::string_view text, bool& isInteger);
+
+        /*! \brief Decode an escape sequence, the backslash being already read, and append it to _result_.
+         *
+         * \param source An object with the methods <pre> int get() </pre> and <pre> int peek() </pre>,
+         * returning the next character as an unsigned char, or a negative value at the end of the input.
+         * \param result The string receiving the character.
+         */
+        template<class Source>
+        static void decodeSequence(Source& source, std::string& result);
+
+        /*! \brief Append the code point _c_ to _result_ in UTF-8, U+FFFD if it is not a valid code point.
+         */
+        static void appendUtf8(std::string& result, uint32_t c);
+
+
+    private:
+        /*! Meaning of an escape character, in the high byte of its entry in _sequences_.
+         */
+        enum Kind {
+            LITERAL = 0,    //!< The character itself.
+            CODE = 1,       //!< The code point in the low bytes.
+            HEX = 2         //!< A code point written with the number of hexadecimal digits in the low byte.
+        };
+
+        static const std::array<uint32_t,256> sequences;    //!< Kind and value of each escape character.
+        static const std::array<int8_t,256> hexValues;      //!< Value of each hexadecimal digit, -1 otherwise.
+
+        /*! Build the table _sequences_.
+         */
+        static constexpr std::array<uint32_t,256> makeSequences();
+
+        /*! Build the table _hexValues_.
+         */
+        static constexpr std::array<int8_t,256> makeHexValues();
+
+        /*! Read up to _count_ hexadecimal digits.
+         */
+        template<class Source>
+        static uint32_t readHex(Source& source, int count);
+};
+
+
+//****************************** Templates *******************************//
+template<class Source>
+uint32_t Escape::readHex(Source& source, int count)
+{
+    uint32_t value = 0;
+    for(int i = 0; i < count; i++)
+    {
+        int c = source.peek();
+        if(c < 0 || hexValues[static_cast<unsigned char>(c)] < 0)
+            break; // an incomplete sequence keeps the digits read
+        value = (value << 4) | static_cast<uint32_t>(hexValues[static_cast<unsigned char>(source.get())]);
+    }
+    return value;
+}
+
+template<class Source>
+void Escape::decodeSequence(Source& source, std::string& result)
+{
+    int c = source.get();
+    if(c < 0)
+        return;
+    uint32_t entry = sequences[static_cast<unsigned char>(c)];
+    switch(entry >> 24)
+    {
+        case LITERAL:
+            result.push_back(static_cast<char>(c));
+            return;
+        case CODE:
+            appendUtf8(result, entry & 0xFFFFFF);
+            return;
+        default:
+            break;
+    }
+
+    uint32_t code = readHex(source, entry & 0xFF);
+    if(code >= 0xD800 && code <= 0xDBFF && source.peek() == '\\')
+    {
+        // a surrogate pair, written as two escape sequences
+        source.get();
+        if(source.peek() != 'u')
+        {
+            appendUtf8(result, code);
+            decodeSequence(source, result);
+            return;
+        }
+        source.get();
+        uint32_t low = readHex(source, 4);
+        if(low >= 0xDC00 && low <= 0xDFFF)
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        else
+        {
+            appendUtf8(result, code);
+            code = low;
+        }
+    }
+    appendUtf8(result, code);
+}
+
+#endif // ESCAPE_H
@@ -0,0 +1,317 @@
+#include "FeedReader.hpp"
+#include "Escape.hpp"
+#include <stdexcept>
+#include <cstdlib>
+#include <limits>
+
+namespace {
+
+inline bool isBlank(char c) {
+    return c==' ' || c=='\t' || c=='\n' || c=='\r'; }
+
+inline bool isDigit(char c) {
+    return c>='0' && c<='9'; }
+
+inline bool isNumberChar(char c) {
+    return isDigit(c) || c=='-' || c=='+' || c=='.' || c=='e' || c=='E'; }
+
+}
+
+
+//******************************** Constructors *******************************//
+FeedReader::FeedReader() :
+    state(VALUE),
+    readingKey(false),
+    escaped(false),
+    streamRoot(false),
+    offset(0),
+    tokenStart(0),
+    keys(&ownKeys)
+{}
+
+
+//****************************** Public functions *******************************//
+void FeedReader::setKeyTable(KeyTable* table)
+{
+    keys = table;
+}
+
+void FeedReader::setStreamRoot(bool stream)
+{
+    streamRoot = stream;
+}
+
+void FeedReader::feed(std::string_view chunk)
+{
+    const char* p = chunk.data();
+    const char* end = p + chunk.size();
+    while(p < end)
+    {
+        char c = *p;
+        switch(state)
+        {
+            case STRING:
+                {
+                    // the text up to the next quote or backslash is copied at once
+                    if(escaped)
+                    {
+                        token.push_back(*p++);
+                        escaped = false;
+                    }
+                    const char* run = p;
+                    while(p < end && *p != '"' && *p != '\\')
+                        p++;
+                    token.append(run, p - run);
+                    if(p == end)
+                        continue;
+                    if(*p == '\\')
+                    {
+                        token.push_back(*p++);
+                        escaped = true;
+                        continue;
+                    }
+                    p++;
+                    if(!Escape::isJson(token))
+                        fail("FeedReader::feed", offset + (p - 1 - chunk.data()));
+                    if(readingKey)
+                    {
+                        key.clear();
+                        Escape::decode(token, key);
+                        state = COLON;
+                    }
+                    else
+                    {
+                        std::string text;
+                        Escape::decode(token, text);
+                        beginValue() = std::move(text);
+                        endValue();
+                    }
+                }
+                continue;
+
+            case NUMBER:
+            case LITERAL:
+                {
+                    const char* run = p;
+                    if(state == NUMBER)
+                        while(p < end && isNumberChar(*p))
+                            p++;
+                    else
+                        while(p < end && *p >= 'a' && *p <= 'z')
+                            p++;
+                    token.append(run, p - run);
+                    if(p != end)
+                        endScalar(); // the delimiter is read in the next state
+                }
+                continue;
+
+            case FAILED:
+                fail("FeedReader::feed", offset + (p - chunk.data()));
+
+            default:
+                break;
+        }
+
+        p++;
+        if(isBlank(c))
+            continue;
+        switch(state)
+        {
+            case VALUE:
+            case ARRAY_START:
+                tokenStart = offset + (p - 1 - chunk.data());
+                if(c == ']' && state == ARRAY_START)
+                {
+                    stack.pop_back();
+                    endValue();
+                }
+                else if(c == '{')
+                {
+                    Variant& value = beginValue();
+                    value.createMap();
+                    stack.emplace_back(&value, true);
+                    state = MAP_START;
+                }
+                else if(c == '[')
+                {
+                    Variant& value = beginValue();
+                    value.createArray();
+                    stack.emplace_back(&value, false);
+                    state = ARRAY_START;
+                }
+                else if(c == '"')
+                {
+                    token.clear();
+                    readingKey = false;
+                    state = STRING;
+                }
+                else if(isDigit(c) || c == '-')
+                {
+                    token.assign(1, c);
+                    state = NUMBER;
+                }
+                else if(c >= 'a' && c <= 'z')
+                {
+                    token.assign(1, c);
+                    state = LITERAL;
+                }
+                else
+                    fail("FeedReader::feed", offset + (p - 1 - chunk.data()));
+                break;
+
+            case MAP_START:
+            case KEY:
+                if(c == '"')
+                {
+                    token.clear();
+                    readingKey = true;
+                    state = STRING;
+                }
+                else if(c == '}' && state == MAP_START)
+                {
+                    stack.pop_back();
+                    endValue();
+                }
+                else
+                    fail("FeedReader::feed", offset + (p - 1 - chunk.data()));
+                break;
+
+            case COLON:
+                if(c != ':')
+                    fail("FeedReader::feed", offset + (p - 1 - chunk.data()));
+                state = VALUE;
+                break;
+
+            case AFTER_VALUE:
+                if(c == ',')
+                    state = stack.back().isMap ? KEY : VALUE;
+                else if(c == (stack.back().isMap ? '}' : ']'))
+                {
+                    stack.pop_back();
+                    endValue();
+                }
+                else
+                    fail("FeedReader::feed", offset + (p - 1 - chunk.data()));
+                break;
+
+            default:
+                break;
+        }
+    }
+    offset += chunk.size();
+}
+
+void FeedReader::finish()
+{
+    if((state == NUMBER || state == LITERAL) && stack.empty())
+        endScalar();
+    if(inDocument())
+    {
+        state = FAILED;
+        throw std::invalid_argument("FeedReader::finish : incomplete document");
+    }
+}
+
+bool FeedReader::next(Variant& result)
+{
+    if(documents.empty())
+        return false;
+    result = std::move(documents.front());
+    documents.pop_front();
+    return true;
+}
+
+bool FeedReader::inDocument() const
+{
+    return state != VALUE || !stack.empty();
+}
+
+void FeedReader::reset()
+{
+    state = VALUE;
+    escaped = false;
+    offset = 0;
+    stack.clear();
+    documents.clear();
+    root.setToNull();
+}
+
+
+//****************************** Private functions *******************************//
+Variant& FeedReader::beginValue()
+{
+    if(stack.empty())
+        return root;
+    Frame& frame = stack.back();
+    if(!frame.isMap)
+        return frame.item;
+    if(keys)
+        return frame.container->emplace(keys->intern(key));
+    return frame.container->emplace(key);
+}
+
+void FeedReader::endValue()
+{
+    if(stack.empty())
+    {
+        // a root array given by elements is not a document
+        if(!(streamRoot && root.getType() == Variant::SEQUENCE))
+            documents.push_back(std::move(root));
+        root.setToNull();
+        state = VALUE;
+        return;
+    }
+
+    Frame& frame = stack.back();
+    if(!frame.isMap)
+    {
+        if(streamRoot && stack.size() == 1)
+            documents.push_back(std::move(frame.item));
+        else
+            frame.builder.append(std::move(frame.item));
+    }
+    state = AFTER_VALUE;
+}
+
+void FeedReader::endScalar()
+{
+    Variant& value = beginValue();
+    bool isInteger;
+    if(state == LITERAL)
+    {
+        if(token == "true")
+            value = true;
+        else if(token == "false")
+            value = false;
+        else if(token == "null")
+            value.setToNull();
+        else
+            fail("FeedReader::feed", tokenStart);
+    }
+    else if(!Escape::isJsonNumber(token, isInteger))
+        fail("FeedReader::feed", tokenStart);
+    else if(isInteger)
+    {
+        // same types as BasicReader
+        long long num = std::strtoll(token.c_str(), 0, 10);
+        if(num >= std::numeric_limits<int>::min() && num <= std::numeric_limits<int>::max())
+            value = static_cast<int>(num);
+        else
+            value = num;
+    }
+    else
+    {
+        double num = std::atof(token.c_str());
+        if(num >= std::numeric_limits<float>::min() && num <= std::numeric_limits<float>::max())
+            value = static_cast<float>(num);
+        else
+            value = num;
+    }
+    endValue();
+}
+
+void FeedReader::fail(const char* function, size_t at)
+{
+    state = FAILED;
+    throw std::invalid_argument(std::string(function) + " : invalid JSON at byte " + std::to_string(at));
+}
@@ -0,0 +1,148 @@
+#ifndef FEEDREADER_H
+#define FEEDREADER_H
+
+#include "Variant.hpp"
+#include "Shape.hpp"
+#include <deque>
+#include <string>
+#include <string_view>
+
+/*! \brief Class reading JSON documents from chunks of bytes pushed by the caller.
+ *
+ * BasicReader pulls its input from a stream, and blocks until the whole document is available. A FeedReader is
+ * given the bytes as they arrive (from a socket for example) with feed(), and parses each chunk immediately. The
+ * parser stops at the end of the chunk, in the middle of a token if needed (a string, an escape sequence, a
+ * number...), and resumes at the next chunk where it stopped: nothing is read twice.
+ *
+ * The documents completed are queued, and taken with next(). Many documents can be sent on the same connection,
+ * separated by blanks or new lines (JSON Lines) or just concatenated:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * FeedReader reader;
+ * Variant request;
+ * while((size = recv(socket, buffer, sizeof(buffer), 0)) > 0)
+ * {
+ *     reader.feed(std::string_view(buffer, size));
+ *     while(reader.next(request))
+ *         process(request);
+ * }
+ * reader.finish();
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * With setStreamRoot(), the elements of a root array are given one by one as soon as they are complete, so a
+ * large body can be processed before its end is received.
+ *
+ * The syntax is strict JSON (see StrictJsonDialect), and the values have the same types as with JsonReader:
+ * the numbers are packed in arrays and the maps of an array share their keys.
+ * \see BasicReader, Escape
+ */
+class FeedReader
+{
+    public:
+        /*! \brief Construct a reader waiting for its first chunk.
+         */
+        FeedReader();
+
+        /*! \brief Set the table interning the keys of the maps.
+         *
+         * By default, the reader interns the keys in its own table, kept for all the documents it reads.
+         * \param table The table to use, or a null pointer to store a copy of each key.
+         * \see KeyTable
+         */
+        void setKeyTable(KeyTable* table);
+
+        /*! \brief Give the elements of the root arrays as separate values, instead of the arrays themselves.
+         */
+        void setStreamRoot(bool stream);
+
+        /*! \brief Parse the next bytes of the input.
+         *
+         * The documents completed by the chunk are queued for next().
+         * \throw std::invalid_argument is thrown if the input is not valid JSON. The reader must then be reset.
+         */
+        void feed(std::string_view chunk);
+
+        /*! \brief Signal the end of the input, completing a number at the end of the last document.
+         *
+         * \throw std::invalid_argument is thrown if the last document is incomplete.
+         */
+        void finish();
+
+        /*! \brief Take the next document completed.
+         *
+         * \param result A Variant object receiving the document.
+         * \return false if no document is complete, true otherwise.
+         */
+        bool next(Variant& result);
+
+        /*! \brief Check if the reader is in the middle of a document.
+         */
+        bool inDocument() const;
+
+        /*! \brief Drop the documents and the partial document, and wait for a new input.
+         */
+        void reset();
+
+
+
+
+    private:
+        /*! Position of the parser in the grammar.
+         */
+        enum State {
+            VALUE,          //!< A value is expected.
+            ARRAY_START,    //!< A value or the end of the array is expected.
+            MAP_START,      //!< A key or the end of the map is expected.
+            KEY,            //!< A key is expected.
+            COLON,          //!< The colon after a key is expected.
+            AFTER_VALUE,    //!< A comma or the end of the container is expected.
+            STRING,         //!< In a string.
+            NUMBER,         //!< In a number.
+            LITERAL,        //!< In true, false or null.
+            FAILED          //!< An error has been found.
+        };
+
+        /*! A container being read.
+         */
+        struct Frame
+        {
+            Variant* container;     //!< The map or the array.
+            bool isMap;             //!< The container is a map.
+            Variant item;           //!< Array: the element being read, appended when it is complete.
+            ArrayBuilder builder;   //!< Array: packs the numbers and shapes the maps.
+
+            Frame(Variant* container, bool isMap) : container(container), isMap(isMap), builder(*container) {}
+        };
+
+        State state;                    //!< Current state.
+        bool readingKey;                //!< STRING: the string is a key.
+        bool escaped;                   //!< STRING: the last character read is a backslash.
+        bool streamRoot;                //!< The elements of the root arrays are given separately.
+        size_t offset;                  //!< Number of bytes of the previous chunks, for the error messages.
+        size_t tokenStart;              //!< Offset of the current token.
+        std::string token;              //!< The text of the token being read.
+        std::string key;                //!< The last key read.
+        Variant root;                   //!< The document being read.
+        std::deque<Frame> stack;        //!< The containers being read, from the root.
+        std::deque<Variant> documents;  //!< The documents completed, not taken yet.
+        KeyTable ownKeys;               //!< The default table of keys.
+        KeyTable* keys;                 //!< The table interning the keys, or null.
+
+        /*! Get the place of the value starting.
+         */
+        Variant& beginValue();
+
+        /*! Store the value just read in its container, or queue it as a document.
+         */
+        void endValue();
+
+        /*! Convert the token of a number or a literal, and store it.
+         */
+        void endScalar();
+
+        /*! Set the state FAILED and throw an exception for the error at the offset _at_.
+         */
+        [[noreturn]] void fail(const char* function, size_t at);
+};
+
+#endif // FEEDREADER_H
@@ -0,0 +1,471 @@
+#include "Format.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <cstring>
+#include <cmath>
+
+namespace
+{
+    inline void put(std::streambuf* buf, const char* str, size_t length)
+    {
+        buf->sputn(str, length);
+    }
+
+    inline void put(std::streambuf* buf, const char* str)
+    {
+        buf->sputn(str, std::strlen(str));
+    }
+
+    void putUInt(std::streambuf* buf, unsigned long long value, bool negative)
+    {
+        char digits[24];
+        char* p = digits + sizeof(digits);
+        do
+        {
+            *--p = '0' + value % 10;
+            value /= 10;
+        } while(value != 0);
+        if(negative)
+            *--p = '-';
+        put(buf, p, digits + sizeof(digits) - p);
+    }
+
+    void putInt(std::streambuf* buf, long long value)
+    {
+        if(value < 0)
+            putUInt(buf, 0ULL - static_cast<unsigned long long>(value), true);
+        else
+            putUInt(buf, value, false);
+    }
+
+    // finite numbers only, always with a '.' or an exponent to be read back as a floating point number
+    // the shortest precision giving back the same value is used
+    void putReal(std::streambuf* buf, double value, bool isFloat)
+    {
+        char digits[32];
+        int length = std::snprintf(digits, sizeof(digits), "%.*g", isFloat ? 6 : 15, value);
+        if(isFloat ? std::strtof(digits, 0) != static_cast<float>(value) : std::strtod(digits, 0) != value)
+            length = std::snprintf(digits, sizeof(digits), "%.*g", isFloat ? 9 : 17, value);
+        if(std::strpbrk(digits, ".e") == 0)
+        {
+            digits[length++] = '.';
+            digits[length++] = '0';
+        }
+        put(buf, digits, length);
+    }
+
+    // double-quoted string with JSON escape sequences, also valid in YAML
+    void putQuoted(std::streambuf* buf, const char* str, size_t length)
+    {
+        static const char hex[] = "0123456789abcdef";
+        buf->sputc('\"');
+        size_t start = 0;
+        for(size_t i = 0; i < length; i++)
+        {
+            unsigned char c = str[i];
+            if(c >= 0x20 && c != '\"' && c != '\\')
+                continue;
+
+            put(buf, str + start, i - start);
+            start = i + 1;
+            buf->sputc('\\');
+            switch(c)
+            {
+                case '\"':  buf->sputc('\"'); break;
+                case '\\':  buf->sputc('\\'); break;
+                case '\b':  buf->sputc('b'); break;
+                case '\f':  buf->sputc('f'); break;
+                case '\n':  buf->sputc('n'); break;
+                case '\r':  buf->sputc('r'); break;
+                case '\t':  buf->sputc('t'); break;
+                default:
+                    put(buf, "u00");
+                    buf->sputc(hex[c >> 4]);
+                    buf->sputc(hex[c & 0xF]);
+                    break;
+            }
+        }
+        put(buf, str + start, length - start);
+        buf->sputc('\"');
+    }
+}
+
+
+//****************************** JsonFormat *******************************//
+JsonFormat::JsonFormat(std::streambuf* buffer) :
+    buf(buffer),
+    separator(false)
+{}
+
+void JsonFormat::beginValue()
+{
+    if(separator)
+        buf->sputc(',');
+    separator = true;
+}
+
+void JsonFormat::beginDocument() {
+    separator = false; }
+
+void JsonFormat::endDocument() {
+    buf->sputc('\n'); }
+
+void JsonFormat::beginMap(size_t)
+{
+    beginValue();
+    buf->sputc('{');
+    separator = false;
+}
+
+void JsonFormat::key(const char* str, size_t length)
+{
+    beginValue();
+    putQuoted(buf, str, length);
+    buf->sputc(':');
+    separator = false;
+}
+
+void JsonFormat::endMap()
+{
+    buf->sputc('}');
+    separator = true;
+}
+
+void JsonFormat::beginArray(size_t)
+{
+    beginValue();
+    buf->sputc('[');
+    separator = false;
+}
+
+void JsonFormat::item()
+{}
+
+void JsonFormat::endArray()
+{
+    buf->sputc(']');
+    separator = true;
+}
+
+void JsonFormat::writeNull()
+{
+    beginValue();
+    put(buf, "null", 4);
+}
+
+void JsonFormat::writeBool(bool value)
+{
+    beginValue();
+    if(value)
+        put(buf, "true", 4);
+    else
+        put(buf, "false", 5);
+}
+
+void JsonFormat::writeInt(long long value)
+{
+    beginValue();
+    putInt(buf, value);
+}
+
+void JsonFormat::writeUInt(unsigned long long value)
+{
+    beginValue();
+    putUInt(buf, value, false);
+}
+
+void JsonFormat::writeFloat(float value)
+{
+    beginValue();
+    if(std::isfinite(value))
+        putReal(buf, value, true);
+    else
+        put(buf, "null", 4);
+}
+
+void JsonFormat::writeDouble(double value)
+{
+    beginValue();
+    if(std::isfinite(value))
+        putReal(buf, value, false);
+    else
+        put(buf, "null", 4);
+}
+
+void JsonFormat::writeString(const char* str, size_t length)
+{
+    beginValue();
+    putQuoted(buf, str, length);
+}
+
+
+//****************************** YamlFormat *******************************//
+YamlFormat::YamlFormat(std::streambuf* buffer) :
+    buf(buffer),
+    position(ROOT),
+    depth(0),
+    inlineEntry(true),
+    started(false)
+{}
+
+void YamlFormat::beginScalar()
+{
+    if(position == AFTER_KEY)
+        buf->sputc(' ');
+}
+
+void YamlFormat::beginContainer(size_t size, const char* empty)
+{
+    depth++;
+    if(size == 0)
+    {
+        beginScalar();
+        put(buf, empty, 2);
+    }
+    else // the first entry of a container in a sequence is written after the dash
+        inlineEntry = position != AFTER_KEY;
+}
+
+void YamlFormat::newEntry()
+{
+    if(inlineEntry)
+        inlineEntry = false;
+    else
+    {
+        buf->sputc('\n');
+        for(int i = 1; i < depth; i++)
+            put(buf, "  ", 2);
+    }
+}
+
+void YamlFormat::beginDocument()
+{
+    if(started)
+        put(buf, "---\n", 4);
+    started = true;
+    position = ROOT;
+    depth = 0;
+    inlineEntry = true;
+}
+
+void YamlFormat::endDocument() {
+    buf->sputc('\n'); }
+
+void YamlFormat::beginMap(size_t size) {
+    beginContainer(size, "{}"); }
+
+void YamlFormat::key(const char* str, size_t length)
+{
+    newEntry();
+
+    // plain keys for identifiers which can't be read as another type
+    bool plain = length > 0 && (std::isalpha(static_cast<unsigned char>(str[0])) || str[0] == '_');
+    for(size_t i = 1; i < length && plain; i++)
+    {
+        unsigned char c = str[i];
+        plain = std::isalnum(c) || c == '_' || c == '-' || c == '.';
+    }
+    if(plain && length <= 5)
+    {
+        static const char* reserved[] = { "true", "false", "null", "yes", "no", "on", "off", "y", "n" };
+        char lower[6];
+        for(size_t i = 0; i < length; i++)
+            lower[i] = std::tolower(static_cast<unsigned char>(str[i]));
+        lower[length] = '\0';
+        for(size_t i = 0; i < sizeof(reserved) / sizeof(*reserved) && plain; i++)
+            plain = std::strcmp(lower, reserved[i]) != 0;
+    }
+
+    if(plain)
+        put(buf, str, length);
+    else
+        putQuoted(buf, str, length);
+    buf->sputc(':');
+    position = AFTER_KEY;
+}
+
+void YamlFormat::endMap() {
+    depth--; }
+
+void YamlFormat::beginArray(size_t size) {
+    beginContainer(size, "[]"); }
+
+void YamlFormat::item()
+{
+    newEntry();
+    put(buf, "- ", 2);
+    position = AFTER_DASH;
+}
+
+void YamlFormat::endArray() {
+    depth--; }
+
+void YamlFormat::writeNull()
+{
+    beginScalar();
+    put(buf, "null", 4);
+}
+
+void YamlFormat::writeBool(bool value)
+{
+    beginScalar();
+    if(value)
+        put(buf, "true", 4);
+    else
+        put(buf, "false", 5);
+}
+
+void YamlFormat::writeInt(long long value)
+{
+    beginScalar();
+    putInt(buf, value);
+}
+
+void YamlFormat::writeUInt(unsigned long long value)
+{
+    beginScalar();
+    putUInt(buf, value, false);
+}
+
+void YamlFormat::writeFloat(float value) {
+    writeReal(value, true); }
+
+void YamlFormat::writeDouble(double value) {
+    writeReal(value, false); }
+
+void YamlFormat::writeReal(double value, bool isFloat)
+{
+    beginScalar();
+    if(std::isnan(value))
+        put(buf, ".nan", 4);
+    else if(std::isinf(value))
+        put(buf, value < 0 ? "-.inf" : ".inf");
+    else
+        putReal(buf, value, isFloat);
+}
+
+void YamlFormat::writeString(const char* str, size_t length)
+{
+    beginScalar();
+    putQuoted(buf, str, length);
+}
+
+
+//****************************** MessagePackFormat *******************************//
+MessagePackFormat::MessagePackFormat(std::streambuf* buffer) :
+    buf(buffer)
+{}
+
+void MessagePackFormat::writeHeader(unsigned char type, unsigned long long value, int nbBytes)
+{
+    char bytes[9];
+    bytes[0] = type;
+    for(int i = nbBytes; i > 0; i--)
+    {
+        bytes[i] = static_cast<char>(value & 0xFF);
+        value >>= 8;
+    }
+    put(buf, bytes, nbBytes + 1);
+}
+
+void MessagePackFormat::beginDocument()
+{}
+
+void MessagePackFormat::endDocument()
+{}
+
+void MessagePackFormat::beginMap(size_t size)
+{
+    if(size < 16)
+        buf->sputc(static_cast<char>(0x80 | size));
+    else if(size <= 0xFFFF)
+        writeHeader(0xde, size, 2);
+    else
+        writeHeader(0xdf, size, 4);
+}
+
+void MessagePackFormat::key(const char* str, size_t length) {
+    writeString(str, length); }
+
+void MessagePackFormat::endMap()
+{}
+
+void MessagePackFormat::beginArray(size_t size)
+{
+    if(size < 16)
+        buf->sputc(static_cast<char>(0x90 | size));
+    else if(size <= 0xFFFF)
+        writeHeader(0xdc, size, 2);
+    else
+        writeHeader(0xdd, size, 4);
+}
+
+void MessagePackFormat::item()
+{}
+
+void MessagePackFormat::endArray()
+{}
+
+void MessagePackFormat::writeNull() {
+    buf->sputc(static_cast<char>(0xc0)); }
+
+void MessagePackFormat::writeBool(bool value) {
+    buf->sputc(static_cast<char>(value ? 0xc3 : 0xc2)); }
+
+void MessagePackFormat::writeInt(long long value)
+{
+    if(value >= 0)
+        writeUInt(value);
+    else if(value >= -32)
+        buf->sputc(static_cast<char>(value));
+    else if(value >= -128)
+        writeHeader(0xd0, value, 1);
+    else if(value >= -32768)
+        writeHeader(0xd1, value, 2);
+    else if(value >= -2147483647LL - 1)
+        writeHeader(0xd2, value, 4);
+    else
+        writeHeader(0xd3, value, 8);
+}
+
+void MessagePackFormat::writeUInt(unsigned long long value)
+{
+    if(value < 128)
+        buf->sputc(static_cast<char>(value));
+    else if(value <= 0xFF)
+        writeHeader(0xcc, value, 1);
+    else if(value <= 0xFFFF)
+        writeHeader(0xcd, value, 2);
+    else if(value <= 0xFFFFFFFFULL)
+        writeHeader(0xce, value, 4);
+    else
+        writeHeader(0xcf, value, 8);
+}
+
+void MessagePackFormat::writeFloat(float value)
+{
+    unsigned int bits;
+    std::memcpy(&bits, &value, 4);
+    writeHeader(0xca, bits, 4);
+}
+
+void MessagePackFormat::writeDouble(double value)
+{
+    unsigned long long bits;
+    std::memcpy(&bits, &value, 8);
+    writeHeader(0xcb, bits, 8);
+}
+
+void MessagePackFormat::writeString(const char* str, size_t length)
+{
+    if(length < 32)
+        buf->sputc(static_cast<char>(0xa0 | length));
+    else if(length <= 0xFF)
+        writeHeader(0xd9, length, 1);
+    else if(length <= 0xFFFF)
+        writeHeader(0xda, length, 2);
+    else
+        writeHeader(0xdb, length, 4);
+    put(buf, str, length);
+}
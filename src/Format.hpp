@@ -0,0 +1,152 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <streambuf>
+#include <string>
+#include <cstddef>
+
+/*! \brief Output format writing compact JSON.
+ *
+ * An output format receives the events of a document (beginning of a map, key, scalar value...) and writes them
+ * directly in the buffer of an output stream. The formats are used by ObjectWriter and have the same methods, so a
+ * new format only has to provide them.
+ *
+ * The sizes given to beginMap() and beginArray() must be the exact number of entries of the container.
+ * \see YamlFormat, MessagePackFormat, ObjectWriter
+ */
+class JsonFormat
+{
+    public:
+        /*! \brief Construct a JsonFormat object writing in _buffer_.
+         */
+        JsonFormat(std::streambuf* buffer);
+
+        void beginDocument();                       //!< Start a new document.
+        void endDocument();                         //!< End the document with a new line.
+        void beginMap(size_t size);                 //!< Start a map of _size_ entries.
+        void key(const char* str, size_t length);   //!< Write the key of the next map entry.
+        void endMap();                              //!< End the current map.
+        void beginArray(size_t size);               //!< Start an array of _size_ items.
+        void item();                                //!< Start the next item of the current array.
+        void endArray();                            //!< End the current array.
+        void writeNull();                           //!< Write a null value.
+        void writeBool(bool value);                 //!< Write a boolean.
+        void writeInt(long long value);             //!< Write a signed integer.
+        void writeUInt(unsigned long long value);   //!< Write an unsigned integer.
+        void writeFloat(float value);               //!< Write a float. NaN and infinity are written as null.
+        void writeDouble(double value);             //!< Write a double. NaN and infinity are written as null.
+        void writeString(const char* str, size_t length);   //!< Write a string, with JSON escape sequences.
+
+
+    private:
+        std::streambuf* buf;    //!< The buffer of the output stream.
+        bool separator;         //!< A ',' must be written before the next value.
+
+        /*! Write the separator before a value.
+         */
+        void beginValue();
+};
+
+
+/*! \brief Output format writing block style YAML.
+ *
+ * Maps and sequences are written one entry per line, with an indentation of two spaces for each level.
+ * The strings are double-quoted, and the documents are separated by the marker <pre> --- </pre>.
+ * \see JsonFormat
+ */
+class YamlFormat
+{
+    public:
+        /*! \brief Construct a YamlFormat object writing in _buffer_.
+         */
+        YamlFormat(std::streambuf* buffer);
+
+        void beginDocument();
+        void endDocument();
+        void beginMap(size_t size);
+        void key(const char* str, size_t length);
+        void endMap();
+        void beginArray(size_t size);
+        void item();
+        void endArray();
+        void writeNull();
+        void writeBool(bool value);
+        void writeInt(long long value);
+        void writeUInt(unsigned long long value);
+        void writeFloat(float value);
+        void writeDouble(double value);
+        void writeString(const char* str, size_t length);
+
+
+    private:
+        /*! Position of the next value.
+         */
+        enum Position {
+            ROOT,       //!< At the start of the document.
+            AFTER_KEY,  //!< After a key and its ':'.
+            AFTER_DASH  //!< After the '- ' of a sequence entry.
+        };
+
+        std::streambuf* buf;    //!< The buffer of the output stream.
+        Position position;      //!< Position of the next value.
+        int depth;              //!< Number of containers containing the next value.
+        bool inlineEntry;       //!< The next entry is written on the current line.
+        bool started;           //!< A document has been written.
+
+        /*! Write the text before a scalar value.
+         */
+        void beginScalar();
+
+        /*! Write the text before a container, or the whole container if it is empty.
+         */
+        void beginContainer(size_t size, const char* empty);
+
+        /*! Start a new line for the next entry of the current container.
+         */
+        void newEntry();
+
+        /*! Write a floating point number, with the precision of a float if _isFloat_ is set.
+         */
+        void writeReal(double value, bool isFloat);
+};
+
+
+/*! \brief Output format writing MessagePack binary data.
+ *
+ * The smallest encoding is used for each integer, string and container size. The floats are written in 32 bits and
+ * the doubles in 64 bits.
+ * \see JsonFormat
+ */
+class MessagePackFormat
+{
+    public:
+        /*! \brief Construct a MessagePackFormat object writing in _buffer_.
+         */
+        MessagePackFormat(std::streambuf* buffer);
+
+        void beginDocument();
+        void endDocument();
+        void beginMap(size_t size);
+        void key(const char* str, size_t length);
+        void endMap();
+        void beginArray(size_t size);
+        void item();
+        void endArray();
+        void writeNull();
+        void writeBool(bool value);
+        void writeInt(long long value);
+        void writeUInt(unsigned long long value);
+        void writeFloat(float value);
+        void writeDouble(double value);
+        void writeString(const char* str, size_t length);
+
+
+    private:
+        std::streambuf* buf;    //!< The buffer of the output stream.
+
+        /*! Write a type byte followed by the _nbBytes_ lower bytes of _value_ in big-endian order.
+         */
+        void writeHeader(unsigned char type, unsigned long long value, int nbBytes);
+};
+
+#endif // FORMAT_H
@@ -0,0 +1,605 @@
+#include "FrozenDocument.hpp"
+#include "Shape.hpp"
+#include <stdexcept>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FROZENDOCUMENT_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    /*! First bytes of an image: "WPFROZ", 0 and the version of the format, in the order of the machine.
+     */
+    const uint64_t imageMagic = 0x01005A4F52465057ULL;
+}
+
+/*! Builder of the sections of a FrozenDocument.
+ */
+class FrozenDocument::Builder
+{
+    public:
+        std::vector<Node> nodes;
+        std::vector<KeyRef> keys;
+        std::string text;
+
+        /*! Fill the node _index_ with _value_, and append its elements.
+         */
+        void fill(const Variant& value, size_t index)
+        {
+            Node node = { static_cast<uint32_t>(value.getType()), 0, 0 };
+            switch(value.getType())
+            {
+                case Variant::BOOL:
+                    node.data = value.toBool();
+                    break;
+                case Variant::CHAR:
+                case Variant::INT:
+                    node.data = static_cast<uint64_t>(static_cast<long long>(value.toInt()));
+                    break;
+                case Variant::UINT:
+                case Variant::LONG:
+                case Variant::ULONG:
+                    node.data = static_cast<uint64_t>(value.toLong());
+                    break;
+                case Variant::FLOAT:
+                    node.data = bits(value.toFloat());
+                    break;
+                case Variant::DOUBLE:
+                    node.data = bits(value.toDouble());
+                    break;
+                case Variant::STRING:
+                    {
+                        std::string str = value.toString();
+                        node.size = checked(str.size());
+                        node.data = addText(str);
+                    }
+                    break;
+                case Variant::SEQUENCE:
+                    fillArray(value, node);
+                    break;
+                case Variant::MAP:
+                    fillMap(value, node);
+                    break;
+                default:
+                    break;
+            }
+            nodes[index] = node;
+        }
+
+    private:
+        std::unordered_map<std::string,uint32_t> keyOffsets; //!< Offset of the text of each key already added.
+
+        static uint64_t bits(double d)
+        {
+            uint64_t result;
+            std::memcpy(&result, &d, sizeof(result));
+            return result;
+        }
+
+        static uint32_t checked(size_t size)
+        {
+            if(size > std::numeric_limits<uint32_t>::max())
+                throw std::length_error("FrozenDocument::freeze : document too large");
+            return static_cast<uint32_t>(size);
+        }
+
+        uint32_t addText(std::string_view str)
+        {
+            uint32_t offset = checked(text.size());
+            text.append(str.data(), str.size());
+            checked(text.size());
+            return offset;
+        }
+
+        /*! Append _count_ uninitialized nodes, and return the index of the first one.
+         */
+        uint32_t allocate(size_t count)
+        {
+            uint32_t first = checked(nodes.size());
+            nodes.resize(checked(nodes.size() + count));
+            return first;
+        }
+
+        template<class T>
+        void fillPacked(const ArrayView<T>& values, Variant::VariantType type, uint32_t first)
+        {
+            for(size_t i = 0; i < values.size(); i++)
+            {
+                Node& node = nodes[first + i];
+                node.type = type;
+                node.size = 0;
+                if(type == Variant::FLOAT || type == Variant::DOUBLE)
+                    node.data = bits(values[i]);
+                else
+                    node.data = static_cast<uint64_t>(static_cast<long long>(values[i]));
+            }
+        }
+
+        void fillArray(const Variant& value, Node& node)
+        {
+            // the packed arrays are read in place, so _value_ is not modified
+            node.size = checked(value.size());
+            uint32_t first = allocate(node.size);
+            node.data = first;
+            switch(value.getPackedType())
+            {
+                case Variant::INT:      fillPacked(value.getIntArray(), Variant::INT, first); break;
+                case Variant::LONG:     fillPacked(value.getLongArray(), Variant::LONG, first); break;
+                case Variant::FLOAT:    fillPacked(value.getFloatArray(), Variant::FLOAT, first); break;
+                case Variant::DOUBLE:   fillPacked(value.getDoubleArray(), Variant::DOUBLE, first); break;
+                default:
+                    {
+                        const Variant::ArrayType& array = value.getArray();
+                        for(size_t i = 0; i < array.size(); i++)
+                            fill(array[i], first + i);
+                    }
+                    break;
+            }
+        }
+
+        void fillMap(const Variant& value, Node& node)
+        {
+            node.size = checked(value.size());
+            uint32_t first = allocate(node.size);
+            uint32_t firstKey = checked(keys.size());
+            keys.resize(checked(keys.size() + node.size));
+            node.data = first | (static_cast<uint64_t>(firstKey) << 32);
+
+            // the keys are already sorted in a map and in a shape
+            if(value.isShaped())
+            {
+                const Shape& shape = *value.getShape();
+                ArrayView<Variant> values = value.getShapedValues();
+                for(size_t i = 0; i < values.size(); i++)
+                {
+                    setKey(firstKey + i, shape.key(i));
+                    fill(values[i], first + i);
+                }
+            }
+            else
+            {
+                const Variant::MapType& map = value.getMap();
+                size_t i = 0;
+                for(Variant::MapType::const_iterator it = map.begin(); it != map.end(); ++it, ++i)
+                {
+                    setKey(firstKey + i, it->first);
+                    fill(it->second, first + i);
+                }
+            }
+        }
+
+        void setKey(size_t index, const std::string& key)
+        {
+            std::unordered_map<std::string,uint32_t>::iterator it = keyOffsets.find(key);
+            if(it == keyOffsets.end())
+                it = keyOffsets.emplace(key, addText(key)).first;
+            keys[index].offset = it->second;
+            keys[index].size = checked(key.size());
+        }
+};
+
+
+//******************************** Constructors *******************************//
+FrozenDocument::FrozenDocument() :
+    mapping(0),
+    mappingSize(0),
+    nodes(0),
+    keys(0),
+    text(0),
+    nodeCount(0)
+{}
+
+FrozenDocument::FrozenDocument(FrozenDocument&& doc) noexcept :
+    image(std::move(doc.image)),
+    mapping(doc.mapping),
+    mappingSize(doc.mappingSize)
+{
+    doc.mapping = 0;
+    doc.mappingSize = 0;
+    map();
+    doc.map();
+}
+
+FrozenDocument& FrozenDocument::operator= (FrozenDocument&& doc) noexcept
+{
+    if(this != &doc)
+    {
+        unmap();
+        image = std::move(doc.image);
+        mapping = doc.mapping;
+        mappingSize = doc.mappingSize;
+        doc.image.clear();
+        doc.mapping = 0;
+        doc.mappingSize = 0;
+        map();
+        doc.map();
+    }
+    return *this;
+}
+
+FrozenDocument::~FrozenDocument()
+{
+    unmap();
+}
+
+
+//****************************** Public functions *******************************//
+FrozenDocument FrozenDocument::freeze(const Variant& root)
+{
+    Builder builder;
+    builder.nodes.resize(1);
+    builder.fill(root, 0);
+
+    Header header;
+    header.magic = imageMagic;
+    header.nodeCount = builder.nodes.size();
+    header.keyCount = builder.keys.size();
+    header.textSize = builder.text.size();
+
+    // header, nodes, keys and text, each section aligned on 8 bytes
+    size_t nodeBytes = builder.nodes.size() * sizeof(Node);
+    size_t keyBytes = (builder.keys.size() * sizeof(KeyRef) + 7) / 8 * 8;
+    size_t words = (sizeof(Header) + nodeBytes + keyBytes + builder.text.size() + 7) / 8;
+
+    FrozenDocument doc;
+    doc.image.assign(words, 0);
+    char* out = reinterpret_cast<char*>(doc.image.data());
+    std::memcpy(out, &header, sizeof(Header));
+    std::memcpy(out + sizeof(Header), builder.nodes.data(), nodeBytes);
+    if(!builder.keys.empty())
+        std::memcpy(out + sizeof(Header) + nodeBytes, builder.keys.data(), builder.keys.size() * sizeof(KeyRef));
+    std::memcpy(out + sizeof(Header) + nodeBytes + keyBytes, builder.text.data(), builder.text.size());
+    doc.map();
+    return doc;
+}
+
+FrozenValue FrozenDocument::getRoot() const
+{
+    if(nodeCount == 0)
+        return FrozenValue();
+    return FrozenValue(this, 0);
+}
+
+size_t FrozenDocument::imageSize() const {
+    return mapping ? mappingSize : image.size() * sizeof(uint64_t); }
+
+FrozenDocument FrozenDocument::load(const std::string& file)
+{
+    std::ifstream strm(file.c_str(), std::ifstream::in | std::ifstream::binary);
+    if(!strm.is_open())
+        throw std::invalid_argument("FrozenDocument::load : Cannot open file");
+    strm.seekg(0, std::ios::end);
+    std::streamoff size = strm.tellg();
+    strm.seekg(0, std::ios::beg);
+    if(size < static_cast<std::streamoff>(sizeof(Header)) || size % sizeof(uint64_t) != 0)
+        throw std::invalid_argument("FrozenDocument::load : invalid image");
+
+    FrozenDocument doc;
+    doc.image.resize(static_cast<size_t>(size) / sizeof(uint64_t));
+    if(!strm.read(reinterpret_cast<char*>(doc.image.data()), size) ||
+       !checkImage(reinterpret_cast<const char*>(doc.image.data()), static_cast<size_t>(size)))
+        throw std::invalid_argument("FrozenDocument::load : invalid image");
+    doc.map();
+    return doc;
+}
+
+FrozenDocument FrozenDocument::mapFile(const std::string& file)
+{
+#ifdef FROZENDOCUMENT_MMAP
+    int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+        throw std::invalid_argument("FrozenDocument::mapFile : Cannot open file");
+    struct stat status;
+    if(::fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(Header)))
+    {
+        ::close(fd);
+        throw std::invalid_argument("FrozenDocument::mapFile : invalid image");
+    }
+
+    // the mapping keeps the file open, the descriptor is not needed anymore
+    size_t size = static_cast<size_t>(status.st_size);
+    void* data = ::mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED)
+        throw std::invalid_argument("FrozenDocument::mapFile : Cannot map file");
+
+    FrozenDocument doc;
+    doc.mapping = data;
+    doc.mappingSize = size;
+    if(!checkImage(static_cast<const char*>(data), size))
+        throw std::invalid_argument("FrozenDocument::mapFile : invalid image");
+    doc.map();
+    return doc;
+#else
+    return load(file);
+#endif
+}
+
+void FrozenDocument::save(const std::string& file) const
+{
+    std::ofstream strm(file.c_str(), std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    if(!strm.is_open())
+        throw std::invalid_argument("FrozenDocument::save : Cannot open file");
+    if(imageData())
+        strm.write(imageData(), imageSize());
+    else
+    {
+        // an empty document is saved as a header without nodes
+        Header header = { imageMagic, 0, 0, 0 };
+        strm.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    }
+    strm.close();
+    if(!strm)
+        throw std::invalid_argument("FrozenDocument::save : Cannot write file");
+}
+
+
+//****************************** Private functions *******************************//
+void FrozenDocument::map()
+{
+    const char* data = imageData();
+    if(!data)
+    {
+        nodes = 0;
+        keys = 0;
+        text = 0;
+        nodeCount = 0;
+        return;
+    }
+    const Header* header = reinterpret_cast<const Header*>(data);
+    size_t keyBytes = (header->keyCount * sizeof(KeyRef) + 7) / 8 * 8;
+    nodeCount = header->nodeCount;
+    nodes = reinterpret_cast<const Node*>(data + sizeof(Header));
+    keys = reinterpret_cast<const KeyRef*>(data + sizeof(Header) + nodeCount * sizeof(Node));
+    text = data + sizeof(Header) + nodeCount * sizeof(Node) + keyBytes;
+}
+
+void FrozenDocument::unmap()
+{
+#ifdef FROZENDOCUMENT_MMAP
+    if(mapping)
+        ::munmap(mapping, mappingSize);
+#endif
+    mapping = 0;
+    mappingSize = 0;
+}
+
+const char* FrozenDocument::imageData() const
+{
+    if(mapping)
+        return static_cast<const char*>(mapping);
+    return image.empty() ? 0 : reinterpret_cast<const char*>(image.data());
+}
+
+bool FrozenDocument::checkImage(const char* data, size_t size)
+{
+    if(size < sizeof(Header))
+        return false;
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+    if(header.magic != imageMagic)
+        return false;
+
+    // the counts are limited to 2^32 by freeze(), so the sizes don't overflow
+    const uint64_t limit = std::numeric_limits<uint32_t>::max();
+    if(header.nodeCount > limit || header.keyCount > limit || header.textSize > limit)
+        return false;
+    uint64_t keyBytes = (header.keyCount * sizeof(KeyRef) + 7) / 8 * 8;
+    if(sizeof(Header) + header.nodeCount * sizeof(Node) + keyBytes + header.textSize > size)
+        return false;
+
+    const KeyRef* keyRefs = reinterpret_cast<const KeyRef*>(data + sizeof(Header) + header.nodeCount * sizeof(Node));
+    for(uint64_t i = 0; i < header.keyCount; i++)
+        if(static_cast<uint64_t>(keyRefs[i].offset) + keyRefs[i].size > header.textSize)
+            return false;
+
+    // the elements of a container follow it and belong to no other container, so the nodes are a tree
+    const Node* nodeList = reinterpret_cast<const Node*>(data + sizeof(Header));
+    std::vector<bool> owned(header.nodeCount, false);
+    for(uint64_t i = 0; i < header.nodeCount; i++)
+    {
+        const Node& node = nodeList[i];
+        switch(node.type)
+        {
+            case Variant::STRING:
+                if(node.data > header.textSize || node.size > header.textSize - node.data)
+                    return false;
+                break;
+            case Variant::SEQUENCE:
+            case Variant::MAP:
+                {
+                    uint64_t first = node.data & limit;
+                    if(first <= i || first + node.size > header.nodeCount)
+                        return false;
+                    if(node.type == Variant::SEQUENCE ? node.data > limit :
+                                                        (node.data >> 32) + node.size > header.keyCount)
+                        return false;
+                    for(uint64_t n = first; n < first + node.size; n++)
+                    {
+                        if(owned[n])
+                            return false;
+                        owned[n] = true;
+                    }
+                }
+                break;
+            case Variant::SCALAR:
+                return false;
+            default:
+                if(node.type > Variant::UNDEFINED || node.size != 0)
+                    return false;
+                break;
+        }
+    }
+    return true;
+}
+
+
+//****************************** FrozenValue *******************************//
+Variant::VariantType FrozenValue::getType() const
+{
+    if(!doc)
+        return Variant::UNDEFINED;
+    return static_cast<Variant::VariantType>(doc->nodes[index].type);
+}
+
+bool FrozenValue::toBool() const
+{
+    return getType()==Variant::BOOL && doc->nodes[index].data != 0;
+}
+
+long long FrozenValue::toLong() const
+{
+    switch(getType())
+    {
+        case Variant::BOOL:
+        case Variant::CHAR:
+        case Variant::INT:
+        case Variant::UINT:
+        case Variant::LONG:
+        case Variant::ULONG:
+            return static_cast<long long>(doc->nodes[index].data);
+        case Variant::FLOAT:
+        case Variant::DOUBLE:
+            return static_cast<long long>(toDouble());
+        default:
+            return 0;
+    }
+}
+
+double FrozenValue::toDouble() const
+{
+    switch(getType())
+    {
+        case Variant::FLOAT:
+        case Variant::DOUBLE:
+            {
+                double d;
+                std::memcpy(&d, &doc->nodes[index].data, sizeof(d));
+                return d;
+            }
+        case Variant::BOOL:
+        case Variant::CHAR:
+        case Variant::INT:
+        case Variant::UINT:
+        case Variant::LONG:
+        case Variant::ULONG:
+            return static_cast<double>(toLong());
+        default:
+            return 0;
+    }
+}
+
+std::string_view FrozenValue::toString() const
+{
+    if(getType()!=Variant::STRING)
+        return std::string_view();
+    const FrozenDocument::Node& node = doc->nodes[index];
+    return std::string_view(doc->text + node.data, node.size);
+}
+
+size_t FrozenValue::size() const
+{
+    Variant::VariantType type = getType();
+    if(type!=Variant::SEQUENCE && type!=Variant::MAP)
+        return 0;
+    return doc->nodes[index].size;
+}
+
+FrozenValue FrozenValue::operator[] (size_t i) const
+{
+    if(getType()!=Variant::SEQUENCE || i >= doc->nodes[index].size)
+        return FrozenValue();
+    return FrozenValue(doc, static_cast<uint32_t>(doc->nodes[index].data + i));
+}
+
+FrozenValue FrozenValue::operator[] (std::string_view key) const
+{
+    if(getType()!=Variant::MAP)
+        return FrozenValue();
+    const FrozenDocument::Node& node = doc->nodes[index];
+    const FrozenDocument::KeyRef* keys = doc->keys + (node.data >> 32);
+
+    // binary search in the sorted keys
+    size_t low = 0, high = node.size;
+    while(low < high)
+    {
+        size_t middle = (low + high) / 2;
+        std::string_view k(doc->text + keys[middle].offset, keys[middle].size);
+        int cmp = k.compare(key);
+        if(cmp == 0)
+            return FrozenValue(doc, static_cast<uint32_t>((node.data & 0xFFFFFFFF) + middle));
+        if(cmp < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return FrozenValue();
+}
+
+std::string_view FrozenValue::key(size_t i) const
+{
+    if(getType()!=Variant::MAP || i >= doc->nodes[index].size)
+        return std::string_view();
+    const FrozenDocument::KeyRef& k = doc->keys[(doc->nodes[index].data >> 32) + i];
+    return std::string_view(doc->text + k.offset, k.size);
+}
+
+FrozenValue FrozenValue::value(size_t i) const
+{
+    if(getType()!=Variant::MAP || i >= doc->nodes[index].size)
+        return FrozenValue();
+    return FrozenValue(doc, static_cast<uint32_t>((doc->nodes[index].data & 0xFFFFFFFF) + i));
+}
+
+Variant FrozenValue::toVariant() const
+{
+    Variant result;
+    switch(getType())
+    {
+        case Variant::BOOL:
+            result = toBool();
+            break;
+        case Variant::CHAR:
+            result = static_cast<char>(toLong());
+            break;
+        case Variant::INT:
+            result = toInt();
+            break;
+        case Variant::UINT:
+        case Variant::LONG:
+        case Variant::ULONG:
+            result = toLong();
+            break;
+        case Variant::FLOAT:
+            result = toFloat();
+            break;
+        case Variant::DOUBLE:
+            result = toDouble();
+            break;
+        case Variant::STRING:
+            result = std::string(toString());
+            break;
+        case Variant::SEQUENCE:
+            result.createArray();
+            result.reserve(size());
+            for(size_t i = 0; i < size(); i++)
+                result.insert((*this)[i].toVariant());
+            break;
+        case Variant::MAP:
+            result.createMap();
+            for(size_t i = 0; i < size(); i++)
+                result.emplace(key(i), value(i).toVariant());
+            break;
+        default:
+            break;
+    }
+    return result;
+}
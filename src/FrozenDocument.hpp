@@ -0,0 +1,283 @@
+#ifndef FROZENDOCUMENT_H
+#define FROZENDOCUMENT_H
+
+#include "Variant.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class FrozenDocument;
+
+/*! \brief Read-only view on a value of a FrozenDocument.
+ *
+ * A FrozenValue is a small handle (a document and a node index) copied by value. None of its methods modify
+ * anything or throw: a missing key or an index out of range gives an UNDEFINED value, and a conversion to the
+ * wrong type gives a default value. So the lookups can be chained and tested at the end:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * FrozenValue route = config.getRoot()["routes"][3];
+ * if(route["target"].getType() == Variant::STRING)
+ *     forward(route["target"].toString());
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The view is valid while its document exists.
+ * \see FrozenDocument
+ */
+class FrozenValue
+{
+    public:
+        /*! \brief Construct an UNDEFINED value.
+         */
+        FrozenValue() : doc(0), index(0) {}
+
+        //**********************************************************************************************//
+        //**************************************  Type Accessors  **************************************//
+        //**********************************************************************************************//
+        /*! \brief Get the type of the value, UNDEFINED if the value doesn't exist.
+         */
+        Variant::VariantType getType() const;
+
+        /*! \brief Check if the value is null.
+         */
+        bool isNull() const {
+            return getType()==Variant::NULLTYPE; }
+
+        /*! \brief Check if the value exists.
+         */
+        bool defined() const {
+            return doc != 0; }
+
+        /*! \brief Check if the value doesn't exist.
+         */
+        bool operator!() const {
+            return doc == 0; }
+
+        //**********************************************************************************************//
+        //**************************************  Data Accessors  **************************************//
+        //**********************************************************************************************//
+        /*! \brief Get a boolean value, false for another type.
+         */
+        bool toBool() const;
+
+        /*! \brief Get an integer value, converted from a floating point value. 0 for another type.
+         */
+        long long toLong() const;
+
+        /*! \brief Get an integer value, converted from a floating point value. 0 for another type.
+         */
+        int toInt() const {
+            return static_cast<int>(toLong()); }
+
+        /*! \brief Get a floating point value, converted from an integer value. 0 for another type.
+         */
+        double toDouble() const;
+
+        /*! \brief Get a floating point value, converted from an integer value. 0 for another type.
+         */
+        float toFloat() const {
+            return static_cast<float>(toDouble()); }
+
+        /*! \brief Get the text of a string, stored in the document. Empty for another type.
+         */
+        std::string_view toString() const;
+
+        /*! \brief Get the number of elements of an array or a map, 0 for another type.
+         */
+        size_t size() const;
+
+        /*! \brief Get an element of an array, UNDEFINED if the value is not an array or _i_ is out of range.
+         */
+        FrozenValue operator[] (size_t i) const;
+
+        /*! \brief Get the value of a key of a map, UNDEFINED if the value is not a map or the key doesn't exist.
+         *
+         * The keys are sorted, so the key is found by a binary search.
+         */
+        FrozenValue operator[] (std::string_view key) const;
+
+        /*! \brief Get the value of a key of a map.
+         * \see operator[](std::string_view) const
+         */
+        FrozenValue operator[] (const char* key) const {
+            return (*this)[std::string_view(key)]; }
+
+        /*! \brief Get the key of the entry _i_ of a map, in the sorted order. Empty if _i_ is out of range.
+         */
+        std::string_view key(size_t i) const;
+
+        /*! \brief Get the value of the entry _i_ of a map, in the sorted order.
+         */
+        FrozenValue value(size_t i) const;
+
+        /*! \brief Copy the value and all its elements in a modifiable Variant.
+         */
+        Variant toVariant() const;
+
+
+
+
+    private:
+        const FrozenDocument* doc;  //!< The document, null for an UNDEFINED value.
+        uint32_t index;             //!< The index of the node in the document.
+
+        FrozenValue(const FrozenDocument* doc, uint32_t index) : doc(doc), index(index) {}
+
+        friend class FrozenDocument;
+};
+
+
+/*! \brief Class containing an immutable copy of a Variant tree, compact and safe to read from many threads.
+ *
+ * A FrozenDocument is built once from a Variant with freeze(), and is then never modified: any number of threads
+ * can read it concurrently, without synchronization, and without the copies built on the first const access to a
+ * packed array or a shaped map of a Variant.
+ *
+ * All the document is stored in a single contiguous image:
+ *  - the nodes, 16 bytes each. The elements of an array or a map are contiguous.
+ *  - the keys of the maps, sorted in each map so a key is found by a binary search.
+ *  - the text of the strings and the keys. A key used by many maps is stored once.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * Variant parsed;
+ * JsonReader::parseFile(parsed, "routes.json");
+ * std::shared_ptr<const FrozenDocument> config = std::make_shared<FrozenDocument>(FrozenDocument::freeze(parsed));
+ * // in each worker thread
+ * FrozenValue timeout = config->getRoot()["timeout"];
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The image only contains offsets and indexes, no pointers, so it can be saved to a file with save() and used
+ * again without being parsed nor decoded. mapFile() maps the file in memory and reads the values in place: the
+ * pages of the text are loaded by the system when they are first read.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * // once, when the configuration changes
+ * FrozenDocument::freeze(parsed).save("routes.frozen");
+ * // at each start of the service
+ * FrozenDocument config = FrozenDocument::mapFile("routes.frozen");
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The image is in the byte order of the machine which saved it, and is rejected on a machine with another
+ * byte order. The image of a file is checked once when it is loaded, in a time proportional to its number of nodes
+ * and keys: the types and the sizes of the nodes, and all the indexes and offsets, so a corrupted file is rejected
+ * instead of being read out of bounds.
+ * \see FrozenValue, Variant
+ */
+class FrozenDocument
+{
+    public:
+        /*! \brief Construct an empty document, with an UNDEFINED root.
+         */
+        FrozenDocument();
+
+        FrozenDocument(FrozenDocument&& doc) noexcept;
+
+        FrozenDocument& operator= (FrozenDocument&& doc) noexcept;
+
+        /*! \brief Release the image, unmapping its file if it was mapped.
+         */
+        ~FrozenDocument();
+
+        /*! \brief Build an immutable copy of _root_.
+         *
+         * _root_ is not modified: its packed arrays and shaped maps are read in place.
+         * \throw std::length_error is thrown if the document has more than 2^32 nodes, keys or characters.
+         */
+        static FrozenDocument freeze(const Variant& root);
+
+        /*! \brief Load a document saved by save(), copying it in memory.
+         *
+         * \throw std::invalid_argument is thrown if the file cannot be read, or is not the image of a document.
+         */
+        static FrozenDocument load(const std::string& file);
+
+        /*! \brief Map in memory a document saved by save(), and read it in place.
+         *
+         * The file must not be modified while it is mapped: it should be replaced by a new file instead. On the
+         * systems without mmap(), the file is loaded with load().
+         * \throw std::invalid_argument is thrown if the file cannot be read, or is not the image of a document.
+         */
+        static FrozenDocument mapFile(const std::string& file);
+
+        /*! \brief Save the image of the document in the file _file_.
+         *
+         * \throw std::invalid_argument is thrown if the file cannot be written.
+         */
+        void save(const std::string& file) const;
+
+        /*! \brief Get the root of the document.
+         */
+        FrozenValue getRoot() const;
+
+        /*! \brief Get the size of the image of the document, in bytes.
+         */
+        size_t imageSize() const;
+
+
+
+
+    private:
+        /*! A value of the document.
+         *  _data_ is the value of a scalar (the bits of a double for FLOAT and DOUBLE), the offset of the text of
+         *  a string, the index of the first element of an array, or the index of the first element (low 32 bits)
+         *  and of the first key (high 32 bits) of a map.
+         */
+        struct Node
+        {
+            uint32_t type;
+            uint32_t size;
+            uint64_t data;
+        };
+
+        /*! A key of a map, in the text of the document.
+         */
+        struct KeyRef
+        {
+            uint32_t offset;
+            uint32_t size;
+        };
+
+        /*! Start of the image.
+         */
+        struct Header
+        {
+            uint64_t magic;
+            uint64_t nodeCount;
+            uint64_t keyCount;
+            uint64_t textSize;
+        };
+
+        class Builder;
+
+        std::vector<uint64_t> image;    //!< The storage of the document, aligned for the nodes.
+        void* mapping;                  //!< The file mapped in memory, used instead of _image_, or null.
+        size_t mappingSize;             //!< The size of the file mapped.
+        const Node* nodes;              //!< The nodes, in the image.
+        const KeyRef* keys;             //!< The keys, in the image.
+        const char* text;               //!< The text of the strings and the keys, in the image.
+        uint64_t nodeCount;             //!< Number of nodes, 0 for an empty document.
+
+        /*! Set the pointers on the sections of the image.
+         */
+        void map();
+
+        /*! Unmap the file mapped, if any.
+         */
+        void unmap();
+
+        /*! Get the start of the image, null for an empty document.
+         */
+        const char* imageData() const;
+
+        /*! Check that _data_ contains the image of a document of _size_ bytes: the header, the nodes (types,
+         *  sizes, ranges of text, elements and keys, each node belonging to one container) and the keys.
+         */
+        static bool checkImage(const char* data, size_t size);
+
+        FrozenDocument(const FrozenDocument&) = delete;
+        FrozenDocument& operator= (const FrozenDocument&) = delete;
+
+        friend class FrozenValue;
+};
+
+#endif // FROZENDOCUMENT_H
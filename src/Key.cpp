@@ -0,0 +1,57 @@
+#include "Key.hpp"
+
+const std::string& Key::empty()
+{
+    static const std::string text;
+    return text;
+}
+
+std::ostream& operator<< (std::ostream& os, const Key& key)
+{
+    return os << key.str();
+}
+
+
+//******************************** Constructors *******************************//
+KeyTable::KeyTable() :
+    purgeSize(1024)
+{}
+
+
+//****************************** Public functions *******************************//
+Key KeyTable::intern(std::string_view text)
+{
+    std::unordered_map<std::string_view,Key>::iterator it = keys.find(text);
+    if(it != keys.end())
+        return it->second;
+
+    if(keys.size() >= purgeSize)
+    {
+        purge();
+        purgeSize = keys.size() * 2 < 1024 ? 1024 : keys.size() * 2;
+    }
+
+    // the index points to the text of the key itself
+    Key key(text);
+    keys.emplace(key.str(), key);
+    return key;
+}
+
+size_t KeyTable::size() const {
+    return keys.size(); }
+
+void KeyTable::purge()
+{
+    for(std::unordered_map<std::string_view,Key>::iterator it = keys.begin(); it != keys.end(); )
+    {
+        if(it->second.data->refs.load(std::memory_order_acquire) == 1)
+            it = keys.erase(it);
+        else
+            ++it;
+    }
+}
+
+void KeyTable::clear()
+{
+    keys.clear();
+}
@@ -0,0 +1,215 @@
+#ifndef KEY_H
+#define KEY_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <atomic>
+#include <ostream>
+
+/*! \brief Class containing the text of a map key, shared between the copies of the key.
+ *
+ * A Key is a reference counted handle on an immutable string: copying a key doesn't copy its text.
+ * The keys returned by a KeyTable are interned: all the keys with the same text share the same storage, so two
+ * interned keys are compared by a pointer comparison when they are equal. The keys are ordered by their text, but
+ * the first 8 bytes are also stored in an integer, so most different keys are ordered without comparing the strings.
+ *
+ * The reference count is atomic, so the keys of a document can be shared between threads.
+ * \see KeyTable, Variant
+ */
+class Key
+{
+    public:
+        //**********************************************************************************************//
+        //********************************  Constructors / Destructors  ********************************//
+        //**********************************************************************************************//
+        /*! \brief Construct an empty key.
+         */
+        Key() : data(0) {}
+
+        /*! \brief Construct a key with its own copy of _text_, not interned.
+         */
+        explicit Key(std::string_view text) : data(new Data(std::string(text))) {}
+
+        /*! \brief Construct a key with its own copy of _text_, not interned.
+         */
+        explicit Key(const char* text) : data(new Data(std::string(text))) {}
+
+        /*! \brief Construct a key taking the content of _text_, not interned.
+         */
+        explicit Key(std::string&& text) : data(new Data(std::move(text))) {}
+
+        Key(const Key& k) : data(k.data) {
+            acquire(); }
+
+        Key(Key&& k) noexcept : data(k.data) {
+            k.data = 0; }
+
+        ~Key() {
+            release(); }
+
+        Key& operator= (const Key& k)
+        {
+            if(data != k.data)
+            {
+                k.acquire();
+                release();
+                data = k.data;
+            }
+            return *this;
+        }
+
+        Key& operator= (Key&& k) noexcept
+        {
+            if(this != &k)
+            {
+                release();
+                data = k.data;
+                k.data = 0;
+            }
+            return *this;
+        }
+
+        //**********************************************************************************************//
+        //**************************************  Data Accessors  **************************************//
+        //**********************************************************************************************//
+        /*! \brief Get the text of the key.
+         */
+        const std::string& str() const {
+            return data ? data->text : empty(); }
+
+        operator const std::string& () const {
+            return str(); }
+
+        operator std::string_view () const {
+            return str(); }
+
+        const char* c_str() const {
+            return str().c_str(); }
+
+        size_t size() const {
+            return str().size(); }
+
+        /*! \brief Check if two keys share the same storage.
+         */
+        bool sameStorage(const Key& k) const {
+            return data == k.data; }
+
+        friend bool operator== (const Key& a, const Key& b) {
+            return a.data == b.data || (a.prefix() == b.prefix() && a.str() == b.str()); }
+        friend bool operator!= (const Key& a, const Key& b) {
+            return !(a == b); }
+        friend bool operator< (const Key& a, const Key& b)
+        {
+            if(a.data == b.data)
+                return false;
+            if(a.prefix() != b.prefix())
+                return a.prefix() < b.prefix();
+            return a.str() < b.str();
+        }
+
+        friend bool operator== (const Key& a, std::string_view b) {
+            return std::string_view(a.str()) == b; }
+        friend bool operator< (const Key& a, std::string_view b) {
+            return std::string_view(a.str()) < b; }
+        friend bool operator< (std::string_view a, const Key& b) {
+            return a < std::string_view(b.str()); }
+
+
+
+
+    private:
+        /*! The shared storage of a key.
+         */
+        struct Data
+        {
+            std::atomic<unsigned int> refs;
+            const std::string text;
+            const uint64_t prefix;  //!< The first 8 bytes of the text, big-endian and padded with zeros.
+
+            Data(std::string&& text) : refs(1), text(std::move(text)), prefix(makePrefix(this->text)) {}
+        };
+
+        Data* data; //!< The storage of the key, null for an empty key.
+
+        friend class KeyTable;
+
+
+        void acquire() const
+        {
+            if(data)
+                data->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void release()
+        {
+            if(data && data->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete data;
+            data = 0;
+        }
+
+        static const std::string& empty();
+
+        /*! Get the prefix of the text. Two texts with different prefixes are in the order of their prefixes.
+         */
+        uint64_t prefix() const {
+            return data ? data->prefix : 0; }
+
+        static uint64_t makePrefix(std::string_view text)
+        {
+            uint64_t prefix = 0;
+            for(size_t i = 0; i < 8; i++)
+                prefix = (prefix << 8) | (i < text.size() ? static_cast<unsigned char>(text[i]) : 0);
+            return prefix;
+        }
+};
+
+/*! \brief Write the text of a key in a stream.
+ */
+std::ostream& operator<< (std::ostream& os, const Key& key);
+
+
+/*! \brief Class interning the keys of maps, so the keys with the same text share their storage.
+ *
+ * A KeyTable is used by a reader for all the documents it reads, and can be shared by many readers.
+ * An array of records then stores a single copy of each field name.
+ *
+ * The table keeps a reference on each key. The keys not used anymore by a document are removed by purge(),
+ * which is also called automatically when the table has doubled since the last purge.
+ * \note A KeyTable is not thread safe, but the keys it returns can be used in any thread.
+ * \see Key
+ */
+class KeyTable
+{
+    public:
+        KeyTable();
+
+        /*! \brief Get the interned key of _text_, adding it to the table if needed.
+         */
+        Key intern(std::string_view text);
+
+        /*! \brief Get the number of keys of the table.
+         */
+        size_t size() const;
+
+        /*! \brief Remove the keys only used by the table.
+         */
+        void purge();
+
+        /*! \brief Remove all the keys. The keys used by the documents are still valid.
+         */
+        void clear();
+
+
+
+
+    private:
+        std::unordered_map<std::string_view,Key> keys; //!< The keys, indexed by their own text.
+        size_t purgeSize;                               //!< Size of the table triggering the next purge.
+
+        KeyTable(const KeyTable&) = delete;
+        KeyTable& operator= (const KeyTable&) = delete;
+};
+
+#endif // KEY_H
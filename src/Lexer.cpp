@@ -1,39 +1,8 @@
 #include "Lexer.hpp"
+#include "Escape.hpp"
 #include <limits>
 
 
-inline void utf8Convert(std::string& result, unsigned int hex)
-{
-	if(hex <= 0x7F) // 1 byte
-	{
-		result.push_back(hex); // 0b 0xxx xxxx
-	}
-	else if(hex <= 0x7FF) // 2 byte
-	{
-		result.push_back((hex>>6) | 0XC0); // 0b 110x xxxx
-		result.push_back((hex%0x40) | 0x80); // 0b 10xx xxxx
-	}
-	else if(hex <= 0xFFFF) // 3 byte
-	{
-		result.push_back((hex>>12) | 0xE0); // 0b 1110 xxxx
-		result.push_back((hex>>6)%0x40 | 0x80); // 0b 10xx xxxx
-		result.push_back((hex%0x40) | 0x80); // 0b 10xx xxxx
-	}
-	else if(hex <= 0x1FFFFF) // 4 byte
-	{
-		result.push_back((hex>>18) | 0xF0); // 0b 1111 0xxx
-		result.push_back((hex>>12)%0x40 | 0x80); // 0b 10xx xxxx
-		result.push_back((hex>>6)%0x40 | 0x80); // 0b 10xx xxxx
-		result.push_back((hex%0x40) | 0x80); // 0b 10xx xxxx
-	}
-}
-
-inline bool isHexChar(char c)
-{
-	// return c>='0' && c<='f' && (c<='F' || c>='a') && (c>='A' || c<='9'); // true(5,5,6) false(1,4,3,2)  => if often false 
-	return (c<='9' && c>='0') || (c<='F' && c>='A') || (c>='a' && c<='f'); // true(2,4,6) false(5,4,3,4)  => if often true
-}
-
 inline bool isAlnumChar(char c)
 {
 	return (c<='9' && c>='0') || (c<='Z' && c>='A') || (c>='a' && c<='z');
@@ -106,17 +75,48 @@ inline bool isAnchorChar(char c)
 
 
 Lexer::Lexer(std::istream& input) :
-	stream(input), /* open in binary mode! */
+	decoded(0),
+	stream(&input), /* open in binary mode! */
 	column(0),
-	prevIndent(0)
-{}
+	prevIndent(0),
+	flowLevel(0),
+	plain(false),
+	charBuf('\n')
+{
+	encoding = readEncoding(input);
+}
 
-std::string Lexer::getValue()
+const std::string& Lexer::getValue() const
 {
 	return value;
 }
 
-Encoding Lexer::readEncoding()
+bool Lexer::isPlain() const
+{
+	return plain;
+}
+
+Encoding Lexer::getEncoding() const
+{
+	return encoding;
+}
+
+void Lexer::setValidation(bool validate)
+{
+	if(!transcoder)
+	{
+		if(!validate)
+			return;
+		// the UTF-8 input is read directly, until it must be validated
+		transcoder.reset(new TranscodingBuffer(stream->rdbuf(), UTF8));
+		decoded.rdbuf(transcoder.get());
+		decoded.exceptions(std::istream::badbit);
+		stream = &decoded;
+	}
+	transcoder->setValidation(validate);
+}
+
+Encoding Lexer::readEncoding(std::istream& input)
 {
 	/*
 	UTF32_BE  BOM  =>  00 00 FE FF
@@ -130,19 +130,44 @@ Encoding Lexer::readEncoding()
 	UTF8      BOM  =>  EF BB BF
 	UTF8      ---  =>  other
 	*/
-	// Not supported
-	return UTF8;
+	std::streambuf* source = input.rdbuf();
+	if(!source)
+		return UTF8;
+	unsigned char bytes[4];
+	size_t count = 0;
+	for(int c; count < 4 && (c = source->sbumpc()) != std::char_traits<char>::eof(); )
+		bytes[count++] = static_cast<unsigned char>(c);
+
+	size_t bomSize;
+	Encoding detected = detectEncoding(bytes, count, bomSize);
+
+	// put back the bytes following the BOM, the others are given to the transcoder
+	size_t kept = count;
+	while(kept > bomSize && source->sungetc() != std::char_traits<char>::eof())
+		kept--;
+	if(detected != UTF8 || kept > bomSize)
+	{
+		std::string_view prefix(reinterpret_cast<const char*>(bytes) + bomSize, kept - bomSize);
+		transcoder.reset(new TranscodingBuffer(source, detected, prefix));
+		decoded.rdbuf(transcoder.get());
+		decoded.exceptions(std::istream::badbit); // forward the validation errors
+		stream = &decoded;
+	}
+	return detected;
 }
 
 Lexer::TokenInfo Lexer::next(size_t indentation)
 {
 	prevIndent = indentation;
+	plain = false;
 	size_t retIndent;
 	char c;
-	do
+	while(true)
 	{
+		char prev;
 		do
 		{
+			prev = charBuf;
 			retIndent = column;
 			c = getChar();
 			if(eof())
@@ -150,7 +175,7 @@ Lexer::TokenInfo Lexer::next(size_t indentation)
 		} while(isBlank(c));
 
 		// comments
-		if( (c == '#' && isBlank(charBuf))  ||
+		if( (c == '#' && isBlank(prev))  ||
 			(c == '/' && peekChar() == '/')
 		   )
 		{
@@ -163,7 +188,22 @@ Lexer::TokenInfo Lexer::next(size_t indentation)
 			charBuf = ' ';
 			continue;
 		}
-	} while(0);
+		break;
+	}
+
+	// document markers and directives
+	if(retIndent == 0 && flowLevel == 0)
+	{
+		if(c == '%')
+			return readDirective(), TokenInfo({ retIndent, DIRECTIVE });
+		if(c == '-' || c == '.')
+		{
+			if(readMarker(c))
+				return TokenInfo({ retIndent, c == '-' ? DOCUMENT_START : DOCUMENT_END });
+			if(value.size() > 1)
+				return readPlainScalar(false), TokenInfo({ retIndent, SCALAR });
+		}
+	}
 
 	// block indicators
 	if(c == '?' && isBlank(peekChar()))
@@ -175,13 +215,13 @@ Lexer::TokenInfo Lexer::next(size_t indentation)
 	
 	// flow indicators
 	if(c == '{')
-		return TokenInfo({ retIndent, FLOW_MAP_BEGIN });
+		return flowLevel++, TokenInfo({ retIndent, FLOW_MAP_BEGIN });
 	if(c == '}')
-		return TokenInfo({ retIndent, FLOW_MAP_END });
+		return flowLevel -= (flowLevel > 0), TokenInfo({ retIndent, FLOW_MAP_END });
 	if(c == '[')
-		return TokenInfo({ retIndent, FLOW_SEQ_BEGIN });
+		return flowLevel++, TokenInfo({ retIndent, FLOW_SEQ_BEGIN });
 	if(c == ']')
-		return TokenInfo({ retIndent, FLOW_SEQ_END });
+		return flowLevel -= (flowLevel > 0), TokenInfo({ retIndent, FLOW_SEQ_END });
 	if(c == ',')
 		return TokenInfo({ retIndent, FLOW_DELIMITER });
 	
@@ -204,16 +244,17 @@ Lexer::TokenInfo Lexer::next(size_t indentation)
 		return readTagName(), TokenInfo({ retIndent, TAG });
 	
 	// others
-	return readPlainScalar(true), TokenInfo({ retIndent, SCALAR }); // TODO : replace true by *is in flow*
+	value.assign(1, c);
+	return readPlainScalar(flowLevel > 0), TokenInfo({ retIndent, SCALAR });
 }
 
 char Lexer::getChar()
 {
-	charBuf = stream.get();
+	charBuf = stream->get();
 	if(charBuf == '\r') {
-		charBuf == '\n';
-		if(stream.peek() == '\n')
-			stream.get();
+		charBuf = '\n';
+		if(stream->peek() == '\n')
+			stream->get();
 	}
 	if(charBuf == '\n')
 		column = 0;
@@ -225,17 +266,17 @@ char Lexer::getChar()
 void Lexer::ungetChar()
 {
 	column--;
-	stream.unget();
+	stream->unget();
 }
 
 char Lexer::peekChar()
 {
-	return stream.peek();
+	return stream->peek();
 }
 
 bool Lexer::eof()
 {
-	return stream.eof();
+	return stream->eof();
 }
 
 void Lexer::skipComments(bool multiline)
@@ -262,6 +303,40 @@ void Lexer::skipComments(bool multiline)
 	}
 }
 
+// a line starting with "---" or "..." followed by a blank
+// the characters read are left in value otherwise
+bool Lexer::readMarker(char c)
+{
+	value.assign(1, c);
+	while(value.size() < 3 && peekChar() == c)
+		value.push_back(getChar());
+	if(value.size() == 3 && (eof() || isBlank(peekChar())))
+	{
+		value.clear();
+		return true;
+	}
+	return false;
+}
+
+// error handling:
+//     - directives are not interpreted, only their text is kept
+void Lexer::readDirective()
+{
+	std::string& result = value;
+	result.clear();
+	while(!eof())
+	{
+		char c = peekChar();
+		if(eof() || c == '\n' || c == '\r')
+			break;
+		if(c == '#' && !result.empty() && isBlank(result[result.size()-1]))
+			break;
+		result.push_back(getChar());
+	}
+	while(!result.empty() && isBlank(result[result.size()-1]))
+		result.erase(result.size()-1);
+}
+
 void Lexer::readAnchorName()
 {
 	std::string& result = value;
@@ -323,7 +398,7 @@ void Lexer::readTagName()
 //     - only header and comment on first line
 //     - only one caracter for explicit indentation
 //     - no spaces between header caracters (except comment)
-//     - less indented lines lead to errors
+//     - less indented lines end the scalar
 void Lexer::readBlockScalar(bool folded)
 {
 	std::string& result = value;
@@ -357,62 +432,61 @@ void Lexer::readBlockScalar(bool folded)
 	}
 
 	// read content text
-	bool lastIsFolded = false;
-	int nbEndLine = 0;
+	bool first = true;
+	bool lastIsMore = false; // last line is more indented, so it is never folded
+	size_t nbEndLine = 0;
 	while(!eof())
 	{
 		// read indentation
-		char c;
-		while(!eof())
+		char c = peekChar();
+		while(!eof() && c == ' ' && !(indentIsSet && column >= indent))
 		{
+			getChar();
 			c = peekChar();
-			if(c == ' ' || c == '\t')
-			{
-				getChar();
-				if(indentIsSet && column == indent)
-					break;
-			}
-			else
-				break;
 		}
 
-		c = peekChar();
-		if(c == '\n' || '\t')
+		if(eof())
+			break;
+		if(c == '\n' || c == '\r')
 		{
 			getChar();
 			nbEndLine++;
-			lastIsFolded = false;
 			continue;
 		}
-		else if(eof() || column < indent)
+		if(column < indent)
 			break;
-		else if(c != ' ' && c != '\t')
+		if(!indentIsSet)
 		{
-			if(!indentIsSet)
-				indent = column;
-			if(folded)
-			{
-				if(lastIsFolded)
-					result.push_back(' ');
-				lastIsFolded = true;
-				nbEndLine--;
-			}
+			indent = column;
+			indentIsSet = true;
 		}
-		result.append(nbEndLine, '\n');
+
+		bool more = (c == ' ' || c == '\t');
+		if(folded && !first && !more && !lastIsMore)
+		{
+			if(nbEndLine == 1)
+				result.push_back(' ');
+			else
+				result.append(nbEndLine - 1, '\n');
+		}
+		else
+			result.append(nbEndLine, '\n');
+		first = false;
+		lastIsMore = more;
 		nbEndLine = 0;
 
 		// read content
-		c = getChar();
 		while(!eof())
 		{
+			c = getChar();
+			if(eof())
+				break;
 			if(c == '\n')
 			{
-				getChar();
 				nbEndLine++;
 				break;
 			}
 			result.push_back(c);
-			c = getChar();
 		}
 	}
 	
@@ -421,7 +495,8 @@ void Lexer::readBlockScalar(bool folded)
 		case 0: // strip
 			break;
 		case 1: // clip
-			result.push_back('\n');
+			if(!first && nbEndLine > 0)
+				result.push_back('\n');
 			break;
 		case 2: // keep
 			result.append(nbEndLine, '\n');
@@ -435,17 +510,19 @@ void Lexer::readBlockScalar(bool folded)
 //     - no comments on multilines
 //     - one key on a line (no compact notation)
 //     - allways expect a single key or terminate by end of line
+//     - value already contains the first characters of the scalar
 void Lexer::readPlainScalar(bool inFlow)
 {
-	std::string  blankBuffer;
 	std::string& result = value;
-	result.clear();
-	ungetChar();
+	blankBuffer.clear();
+	plain = true;
 	int nbEndLine = 0;
 	bool lastIsFolded = true;
 	while(!eof())
 	{
 		char c = getChar();
+		if(eof())
+			break;
 		if(c == '\n')
 		{
 			blankBuffer.clear();
@@ -509,14 +586,16 @@ void Lexer::readPlainScalar(bool inFlow)
 //     - allways expect a single key or terminate by end of line
 void Lexer::readQuotedString(char endChar, bool escape)
 {
-	std::string blankBuffer;
 	std::string& result = value;
 	result.clear();
+	blankBuffer.clear();
 	int nbEndLine = 0;
 	bool lastIsFolded = true;
 	while(!eof())
 	{
 		char c = getChar();
+		if(eof())
+			break;
 		if(c == '\n')
 		{
 			blankBuffer.clear();
@@ -582,7 +661,6 @@ void Lexer::readQuotedString(char endChar, bool escape)
 			}
 			result.push_back(c);
 			getChar();
-			c = getChar();
 		}
 		else if(c != endChar)
 		{
@@ -603,51 +681,19 @@ void Lexer::readQuotedString(char endChar, bool escape)
 
 void Lexer::parseEscape(std::string& result)
 {
-	unsigned int utfNum = 0; // unicodes points
-	int nbChar = 2;
-
-	char c = getChar();
-	switch(c)
+	// the sequence is read with getChar, so the column is kept
+	struct Source
 	{
-	// C escape sequences
-		case '0':   c = 0x00; break; // NUL: '\0'
-		case 'a':   c = 0x07; break; // BEL: '\a'
-		case 'b':   c = 0x08; break; // BS : '\b'
-		case 't':   c = 0x09; break; // TAB: '\t'
-		case 'n':   c = 0x0a; break; // LF : '\n'
-		case 'v':   c = 0x0b; break; // VT : '\v'
-		case 'f':   c = 0x0c; break; // FF : '\f'
-		case 'r':   c = 0x0d; break; // CR : '\r'
-		case 'e':   c = 0x1b; break; // ESC: '\e' may be not recognized
-		case 'U':   nbChar *= 2;     // \Unnnnnnnn (UTF-32)
-		case 'u':   nbChar *= 2;     // \unnnn     (UTF-16)
-	// YAML escape sequences
-		case 'x':                    // \xnn       (UTF-8)
-			for(int i=0; i<nbChar; i++) {
-				if(!eof() && isHexChar(peekChar())) {
-					c = getChar();
-					c -= (c<='9')? '0' : (c<='Z')? ('A'-10) : ('a'-10);
-					utfNum = (utfNum << 4) | c;
-				}
-				else break;
-			}
-			c = 0x00;
-			break;
-		case 'N':   utfNum = 0x0085; break;
-		case '_':   utfNum = 0x00a0; break;
-		case 'L':   utfNum = 0x2028; break;
-		case 'P':   utfNum = 0x2029; break;
-		default:
-			break;
-	}
+		Lexer& lexer;
 
-	if(!eof())
-	{
-		if(utfNum > 0)
-			utf8Convert(result, utfNum);
-		else
-			result.push_back(c);
-	}
+		int get() {
+			char c = lexer.getChar();
+			return lexer.eof() ? -1 : static_cast<unsigned char>(c); }
+
+		int peek() {
+			return lexer.stream->peek(); }
+	} source = { *this };
+	Escape::decodeSequence(source, result);
 }
 
 
@@ -1,7 +1,9 @@
 #ifndef LEXER_HPP
 #define LEXER_HPP
 
+#include "Encoding.hpp"
 #include <istream>
+#include <memory>
 #include <string>
 
 
@@ -18,15 +20,10 @@ enum Token {
 	SCALAR,
 	ALIAS,
 	ANCHOR,
-	TAG
-};
-
-enum Encoding {
-	UTF8,
-	UTF16_LE,
-	UTF16_BE,
-	UTF32_LE,
-	UTF32_BE
+	TAG,
+	DIRECTIVE,
+	DOCUMENT_START,
+	DOCUMENT_END
 };
 
 class Lexer
@@ -41,11 +38,14 @@ class Lexer
 	public:
 		Lexer(std::istream& input);
 
-		Encoding readEncoding();
+		Encoding getEncoding() const;
+		void setValidation(bool validate);
 		TokenInfo next(size_t indentation);
-		std::string getValue();
+		const std::string& getValue() const;
+		bool isPlain() const;
 
 	private:
+		Encoding readEncoding(std::istream& input);
 		char getChar();
 		void ungetChar();
 		char peekChar();
@@ -57,14 +57,22 @@ class Lexer
 		void readAnchorName();
 		void readPlainScalar(bool inFlow);
 		void readTagName();
+		void readDirective();
+		bool readMarker(char c);
 
 		void parseEscape(std::string& result);
 
 	private:
-		std::istream& stream;
+		Encoding encoding;
+		std::unique_ptr<TranscodingBuffer> transcoder;
+		std::istream decoded;
+		std::istream* stream;
 		std::string value;
+		std::string blankBuffer;
 		size_t column;
 		size_t prevIndent;
+		size_t flowLevel;
+		bool plain;
 		char charBuf;
 };
 
@@ -0,0 +1,249 @@
+#ifndef OBJECTREADER_H
+#define OBJECTREADER_H
+
+#include "Reader.hpp"
+#include "Binding.hpp"
+#include "Escape.hpp"
+#include <string>
+#include <vector>
+#include <map>
+#include <limits>
+#include <stdexcept>
+#include <cerrno>
+#include <cstdlib>
+
+/*! \brief Class reading the documents of a Reader directly in C++ objects, without building a Variant.
+ *
+ * The values are read with the pull interface of the Reader and placed in the fields of the object:
+ *  - bool, integer and floating point types, std::string: from the scalars.
+ *  - std::vector<T>: from the arrays.
+ *  - std::map<std::string,T>: from the maps.
+ *  - Variant: any value, as read by the Reader.
+ *  - structures bound with the macros of Binding: from the maps. The unknown keys are skipped,
+ *    and the fields without key are left unchanged.
+ *
+ * A value of a wrong type is skipped and the field is left unchanged. So is a number which does not fit the field:
+ * a fraction or an exponent for an integer, or a value out of the range of the type.
+ * With a strict dialect, an unquoted scalar which is neither a JSON number nor a boolean throws an std::invalid_argument.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * JsonReader reader(&stream);
+ * ObjectReader<StrictJsonDialect> objects(reader);
+ * Point point;
+ * while(objects.next(point))
+ *     process(point);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * \see Binding, BasicReader
+ */
+template<class Dialect>
+class ObjectReader
+{
+    public:
+        //**********************************************************************************************//
+        //**************************************  Public methods  **************************************//
+        //**********************************************************************************************//
+        /*! \brief Construct an ObjectReader object reading the documents of _reader_.
+         */
+        ObjectReader(BasicReader<Dialect>& reader) : reader(reader) {}
+
+        /*! \brief Read the next document of the reader in _object_.
+         *
+         * \param object The object receiving the data.
+         * \return false if the end of the stream is reached before any new document, true otherwise.
+         * \throw std::logic_error is thrown if the stream is not good.
+         */
+        template<class T>
+        bool next(T& object)
+        {
+            if(!reader.beginDocument())
+                return false;
+            read(object);
+            return true;
+        }
+
+        /*! \brief Read the value at the current position of the reader in _object_.
+         */
+        template<class T>
+        void read(T& object)
+        {
+            if(reader.enterMap())
+            {
+                FieldReader visitor(*this);
+                while(reader.nextKey(key))
+                {
+                    visitor.found = false;
+                    Binding<T>::fields(visitor, object);
+                    if(!visitor.found)
+                        reader.skipValue();
+                }
+            }
+            else
+                reader.skipValue();
+        }
+
+        void read(bool& value)
+        {
+            if(readText() && !isString && (text == "true" || text == "false"))
+                value = (text == "true");
+        }
+
+        void read(std::string& value)
+        {
+            if(readText())
+                value.swap(text);
+        }
+
+        void read(Variant& value) {
+            reader.readVariant(value); }
+
+        void read(char& value)                 { readInteger(value); }
+        void read(signed char& value)          { readInteger(value); }
+        void read(unsigned char& value)        { readInteger(value); }
+        void read(short& value)                { readInteger(value); }
+        void read(unsigned short& value)       { readInteger(value); }
+        void read(int& value)                  { readInteger(value); }
+        void read(unsigned int& value)         { readInteger(value); }
+        void read(long& value)                 { readInteger(value); }
+        void read(unsigned long& value)        { readInteger(value); }
+        void read(long long& value)            { readInteger(value); }
+        void read(unsigned long long& value)   { readInteger(value); }
+        void read(float& value)                { readFloat(value); }
+        void read(double& value)               { readFloat(value); }
+        void read(long double& value)          { readFloat(value); }
+
+        template<class T>
+        void read(std::vector<T>& value)
+        {
+            if(!reader.enterArray())
+            {
+                reader.skipValue();
+                return;
+            }
+            value.clear();
+            while(reader.nextItem())
+            {
+                value.push_back(T());
+                read(value.back());
+            }
+        }
+
+        template<class T, class Compare>
+        void read(std::map<std::string,T,Compare>& value)
+        {
+            if(!reader.enterMap())
+            {
+                reader.skipValue();
+                return;
+            }
+            value.clear();
+            while(reader.nextKey(key))
+                read(value[key]);
+        }
+
+
+
+
+    private:
+        BasicReader<Dialect>& reader;   //!< The reader of the stream.
+        std::string key;                //!< Buffer for the keys.
+        std::string text;               //!< Buffer for the scalars.
+        bool isString;                  //!< The last scalar read is a string literal.
+
+
+        /*! Visitor of the fields of a bound structure, reading the field of the current key.
+         */
+        struct FieldReader
+        {
+            ObjectReader& parent;
+            bool found;
+
+            FieldReader(ObjectReader& parent) : parent(parent), found(false) {}
+
+            template<class T>
+            void operator()(const char* name, T& field)
+            {
+                if(!found && parent.key == name)
+                {
+                    found = true;
+                    parent.read(field);
+                }
+            }
+        };
+
+        /*! Read a scalar in _text_. Returns false if the value is not a scalar, or is null.
+         */
+        bool readText()
+        {
+            return reader.readText(text, isString) && !(!isString && (text.empty() || text == "null"));
+        }
+
+        /*! Check the syntax of the number in _text_ if the dialect is strict.
+         *  Returns false for true and false, which are values of a wrong type.
+         */
+        bool checkNumber() const
+        {
+            bool isInteger = false;
+            if(!Dialect::strictSyntax || Escape::isJsonNumber(text, isInteger))
+                return true;
+            if(text == "true" || text == "false")
+                return false;
+            throw std::invalid_argument("ObjectReader::read : invalid JSON number");
+        }
+
+        /*! Read an integer. Hexadecimal and binary numbers are accepted if the dialect allows them.
+         *  The whole text must be read, and the value must fit in T.
+         */
+        template<class T>
+        void readInteger(T& value)
+        {
+            if(!readText() || isString || !checkNumber())
+                return;
+            int base = 10;
+            const char* str = text.c_str();
+            if(Dialect::extendedNumbers && text.size() > 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'b'))
+            {
+                base = str[1] == 'x' ? 16 : 2;
+                str += 2;
+            }
+            char* end = 0;
+            errno = 0;
+            if(str[0] == '-')
+            {
+                long long num = std::strtoll(str, &end, base);
+                if(end != str && *end == '\0' && errno != ERANGE &&
+                   num >= static_cast<long long>(std::numeric_limits<T>::min()))
+                    value = static_cast<T>(num);
+            }
+            else
+            {
+                unsigned long long num = std::strtoull(str, &end, base);
+                if(end != str && *end == '\0' && errno != ERANGE &&
+                   num <= static_cast<unsigned long long>(std::numeric_limits<T>::max()))
+                    value = static_cast<T>(num);
+            }
+        }
+
+        /*! Read a floating point number. A final 'f' is accepted if the dialect is not strict.
+         *  The whole text must be read, and the value must fit in T: an underflow gives the nearest value.
+         */
+        template<class T>
+        void readFloat(T& value)
+        {
+            if(!readText() || isString || !checkNumber())
+                return;
+            const char* str = text.c_str();
+            char* end = 0;
+            long double num;
+            if(sizeof(T) > sizeof(double))
+                num = std::strtold(str, &end);
+            else
+                num = std::strtod(str, &end);
+            if(end == str || (*end != '\0' && (Dialect::strictSyntax || *end != 'f' || end[1] != '\0')))
+                return;
+            if(num > std::numeric_limits<T>::max() || num < -std::numeric_limits<T>::max())
+                return; // out of range, including the infinity returned on overflow
+            value = static_cast<T>(num);
+        }
+};
+
+#endif // OBJECTREADER_H
@@ -0,0 +1,246 @@
+#ifndef OBJECTWRITER_H
+#define OBJECTWRITER_H
+
+#include "Variant.hpp"
+#include "Shape.hpp"
+#include "Binding.hpp"
+#include "Format.hpp"
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <map>
+
+/*! \brief Class writing C++ objects directly in an output stream, without building a Variant.
+ *
+ * The objects are written in the buffer of the output stream with the output _Format_: JsonFormat, YamlFormat
+ * or MessagePackFormat. The following types are accepted:
+ *  - bool, integer and floating point types, std::string and C strings: written as scalars.
+ *  - std::vector<T> and ArrayView<T>: written as arrays.
+ *  - std::map<K,T> with string keys (std::string or Key): written as maps.
+ *  - Variant: written with its content.
+ *  - structures bound with the macros of Binding: written as maps, in the declaration order of the fields.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * ObjectWriter<JsonFormat> writer(&stream);
+ * Point point = { 1, 2, "origin" };
+ * writer.write(point);     // {"x":1,"y":2,"name":"origin"}
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * \see Binding, ObjectReader, Writer
+ */
+template<class Format>
+class ObjectWriter
+{
+    public:
+        //**********************************************************************************************//
+        //**************************************  Public methods  **************************************//
+        //**********************************************************************************************//
+        /*! \brief Construct an ObjectWriter object with the specified output stream.
+         *
+         * \param output The output stream to write in.
+         * \throw std::logic_error is thrown if the stream is not good.
+         */
+        ObjectWriter(std::ostream* output) :
+            ostr(output),
+            format(output->rdbuf())
+        {
+            if(!output->good())
+                throw std::logic_error("ObjectWriter::ObjectWriter : stream error");
+        }
+
+        /*! \brief Write _object_ as a new document of the output stream.
+         *
+         * \throw std::logic_error is thrown if the stream is not good.
+         */
+        template<class T>
+        void write(const T& object)
+        {
+            if(ostr->fail())
+                throw std::logic_error("ObjectWriter::write : writing error");
+            format.beginDocument();
+            writeValue(object);
+            format.endDocument();
+        }
+
+        /*! \brief Write _object_ at the current position of the document.
+         */
+        template<class T>
+        void writeValue(const T& object)
+        {
+            FieldCounter counter;
+            Binding<T>::fields(counter, object);
+            format.beginMap(counter.count);
+            FieldWriter visitor(*this);
+            Binding<T>::fields(visitor, object);
+            format.endMap();
+        }
+
+        void writeValue(bool value)                 { format.writeBool(value); }
+        void writeValue(char value)                 { format.writeInt(value); }
+        void writeValue(signed char value)          { format.writeInt(value); }
+        void writeValue(unsigned char value)        { format.writeUInt(value); }
+        void writeValue(short value)                { format.writeInt(value); }
+        void writeValue(unsigned short value)       { format.writeUInt(value); }
+        void writeValue(int value)                  { format.writeInt(value); }
+        void writeValue(unsigned int value)         { format.writeUInt(value); }
+        void writeValue(long value)                 { format.writeInt(value); }
+        void writeValue(unsigned long value)        { format.writeUInt(value); }
+        void writeValue(long long value)            { format.writeInt(value); }
+        void writeValue(unsigned long long value)   { format.writeUInt(value); }
+        void writeValue(float value)                { format.writeFloat(value); }
+        void writeValue(double value)               { format.writeDouble(value); }
+        void writeValue(long double value)          { format.writeDouble(static_cast<double>(value)); }
+        void writeValue(const std::string& value)   { format.writeString(value.data(), value.size()); }
+        void writeValue(const char* value)          { format.writeString(value, std::char_traits<char>::length(value)); }
+
+        void writeValue(const Variant& value)
+        {
+            switch(value.getType())
+            {
+                case Variant::SEQUENCE:
+                    if(value.isPacked())
+                    {
+                        switch(value.getPackedType())
+                        {
+                            case Variant::INT:      writeValue(value.getIntArray()); break;
+                            case Variant::LONG:     writeValue(value.getLongArray()); break;
+                            case Variant::FLOAT:    writeValue(value.getFloatArray()); break;
+                            default:                writeValue(value.getDoubleArray()); break;
+                        }
+                    }
+                    else
+                    {
+                        const Variant::ArrayType& array = value.getArray();
+                        format.beginArray(array.size());
+                        for(Variant::ArrayType::const_iterator it = array.begin(); it != array.end(); ++it)
+                        {
+                            format.item();
+                            writeValue(*it);
+                        }
+                        format.endArray();
+                    }
+                    break;
+                case Variant::MAP:
+                    if(value.isShaped())
+                    {
+                        const Shape& shape = *value.getShape();
+                        ArrayView<Variant> values = value.getShapedValues();
+                        format.beginMap(values.size());
+                        for(size_t i = 0; i < values.size(); i++)
+                        {
+                            format.key(shape.key(i).c_str(), shape.key(i).size());
+                            writeValue(values[i]);
+                        }
+                        format.endMap();
+                    }
+                    else
+                        writeValue(value.getMap());
+                    break;
+                case Variant::STRING:
+                    writeValue(value.toString());
+                    break;
+                case Variant::CHAR:
+                    {
+                        char c = value.toChar();
+                        format.writeString(&c, 1);
+                    }
+                    break;
+                case Variant::BOOL:
+                    format.writeBool(value.toBool());
+                    break;
+                case Variant::INT:
+                    format.writeInt(value.toInt());
+                    break;
+                case Variant::UINT:
+                case Variant::LONG:
+                case Variant::ULONG:
+                    format.writeInt(value.toLong());
+                    break;
+                case Variant::FLOAT:
+                    format.writeFloat(value.toFloat());
+                    break;
+                case Variant::DOUBLE:
+                    format.writeDouble(value.toDouble());
+                    break;
+                default:
+                    format.writeNull();
+                    break;
+            }
+        }
+
+        template<class T>
+        void writeValue(const std::vector<T>& value)
+        {
+            format.beginArray(value.size());
+            for(typename std::vector<T>::const_iterator it = value.begin(); it != value.end(); ++it)
+            {
+                format.item();
+                writeValue(*it);
+            }
+            format.endArray();
+        }
+
+        template<class T>
+        void writeValue(const ArrayView<T>& value)
+        {
+            format.beginArray(value.size());
+            for(const T* it = value.begin(); it != value.end(); ++it)
+            {
+                format.item();
+                writeValue(*it);
+            }
+            format.endArray();
+        }
+
+        template<class K, class T, class Compare>
+        void writeValue(const std::map<K,T,Compare>& value)
+        {
+            format.beginMap(value.size());
+            for(typename std::map<K,T,Compare>::const_iterator it = value.begin(); it != value.end(); ++it)
+            {
+                std::string_view key = it->first;
+                format.key(key.data(), key.size());
+                writeValue(it->second);
+            }
+            format.endMap();
+        }
+
+
+
+
+    private:
+        std::ostream* ostr; //!< The output stream to write in.
+        Format format;      //!< The output format, writing in the buffer of the stream.
+
+
+        /*! Visitor counting the fields of a bound structure.
+         */
+        struct FieldCounter
+        {
+            size_t count;
+
+            FieldCounter() : count(0) {}
+
+            template<class T>
+            void operator()(const char*, const T&) {
+                count++; }
+        };
+
+        /*! Visitor writing the fields of a bound structure.
+         */
+        struct FieldWriter
+        {
+            ObjectWriter& parent;
+
+            FieldWriter(ObjectWriter& parent) : parent(parent) {}
+
+            template<class T>
+            void operator()(const char* name, const T& field)
+            {
+                parent.format.key(name, std::char_traits<char>::length(name));
+                parent.writeValue(field);
+            }
+        };
+};
+
+#endif // OBJECTWRITER_H
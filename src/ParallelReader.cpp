@@ -0,0 +1,355 @@
+#include "ParallelReader.hpp"
+#include "Reader.hpp"
+#include "Escape.hpp"
+#include "Shape.hpp"
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <streambuf>
+#include <thread>
+
+namespace
+{
+    const size_t npos = static_cast<size_t>(-1);
+
+    inline bool isBlank(char c) {
+        return c==' ' || c=='\t' || c=='\n' || c=='\r'; }
+
+    /*! Input stream buffer on a run of elements in memory, between an opening and a closing character, so it is
+     * read as a whole container without copying the elements.
+     */
+    class ChunkBuffer : public std::streambuf
+    {
+        public:
+            ChunkBuffer(char open, std::string_view elements, char close) :
+                open(open),
+                close(close),
+                elements(elements),
+                segment(0)
+            {
+                setg(&this->open, &this->open, &this->open + 1);
+            }
+
+        protected:
+            int_type underflow()
+            {
+                if(gptr() < egptr())
+                    return traits_type::to_int_type(*gptr());
+                if(++segment == 1 && !elements.empty())
+                {
+                    char* data = const_cast<char*>(elements.data());
+                    setg(data, data, data + elements.size());
+                }
+                else if(segment <= 2)
+                {
+                    segment = 2;
+                    setg(&close, &close, &close + 1);
+                }
+                else
+                    return traits_type::eof();
+                return traits_type::to_int_type(*gptr());
+            }
+
+        private:
+            char open;
+            char close;
+            std::string_view elements;
+            int segment;    //!< 0: the opening character, 1: the elements, 2: the closing character.
+    };
+
+    /*! Get the number of elements of a container read.
+     */
+    size_t countElements(const Variant& value) {
+        return value.getType() == Variant::SEQUENCE || value.getType() == Variant::MAP ? value.size() : 0; }
+}
+
+
+//******************************** Constructors *******************************//
+ParallelReader::ParallelReader(unsigned threadCount) :
+    threadCount(threadCount),
+    chunkSize(1 << 20)
+{
+    if(this->threadCount == 0)
+        this->threadCount = std::thread::hardware_concurrency();
+    if(this->threadCount == 0)
+        this->threadCount = 1;
+}
+
+
+//****************************** Public functions *******************************//
+void ParallelReader::setChunkSize(size_t size)
+{
+    chunkSize = size ? size : 1;
+}
+
+void ParallelReader::parse(Variant& result, std::string_view input)
+{
+    text = input;
+    size_t start = 0;
+    while(start < text.size() && isBlank(text[start]))
+        start++;
+
+    if(text.size() - start < 2 * chunkSize || (text[start] != '[' && text[start] != '{'))
+    {
+        // too small to be split: the text is read as it is, between two blanks
+        ChunkBuffer buffer(' ', text.substr(start), ' ');
+        std::istream stream(&buffer);
+        JsonReader reader(&stream);
+        reader.parse(result);
+        return;
+    }
+
+    buildIndex(start);
+    std::vector<Part> parts;
+    split(0, index.size() - 1, parts);
+    readChunks(parts);
+    stitch(0, parts, result);
+    index = std::vector<size_t>();
+    text = std::string_view();
+}
+
+void ParallelReader::parseFile(Variant& result, const std::string& file)
+{
+    std::ifstream strm(file.c_str(), std::ifstream::in | std::ifstream::binary);
+    if(!strm.is_open())
+        throw std::invalid_argument("ParallelReader::parseFile : Cannot open file");
+    std::string content((std::istreambuf_iterator<char>(strm)), std::istreambuf_iterator<char>());
+    parse(result, content);
+}
+
+
+//****************************** Private functions *******************************//
+void ParallelReader::buildIndex(size_t start)
+{
+    index.clear();
+    std::string nesting;
+    const char* data = text.data();
+    const char* end = data + text.size();
+    for(const char* p = data + start; p < end; p++)
+    {
+        switch(*p)
+        {
+            case '"':
+                // the strings are skipped, with their escaped quotes
+                for(p++; p < end && *p != '"'; p++)
+                    if(*p == '\\')
+                        p++;
+                if(p >= end)
+                    throw std::invalid_argument("ParallelReader::parse : unterminated string");
+                break;
+            case '[':
+            case '{':
+                nesting.push_back(*p == '[' ? ']' : '}');
+                index.push_back(p - data);
+                break;
+            case ']':
+            case '}':
+                if(nesting.empty() || nesting.back() != *p)
+                    throw std::invalid_argument("ParallelReader::parse : unbalanced brackets at byte " +
+                                                std::to_string(p - data));
+                nesting.pop_back();
+                index.push_back(p - data);
+                if(nesting.empty())
+                    return; // end of the root container
+                break;
+            case ',':
+            case ':':
+                index.push_back(p - data);
+                break;
+            default:
+                break;
+        }
+    }
+    throw std::invalid_argument("ParallelReader::parse : unbalanced brackets at the end of the input");
+}
+
+void ParallelReader::split(size_t open, size_t close, std::vector<Part>& parts)
+{
+    // enough chunks for each thread to take a few, so the threads end at the same time
+    size_t cut = (index[close] - index[open]) / (4 * threadCount);
+    if(cut < chunkSize)
+        cut = chunkSize;
+
+    bool isMap = text[index[open]] == '{';
+    size_t runStart = index[open] + 1;   // first element of the current run
+    size_t elementStart = runStart;
+    size_t colon = npos;                 // colon of the current element of a map
+    size_t elementOpen = npos;           // entries of the current element, if it is a container
+    size_t elementClose = npos;
+    int depth = 0;
+    for(size_t e = open + 1; e <= close; e++)
+    {
+        char c = text[index[e]];
+        if(depth > 0)
+        {
+            if(c == '[' || c == '{')
+                depth++;
+            else if((c == ']' || c == '}') && --depth == 0)
+                elementClose = e;
+            continue;
+        }
+        if(c == '[' || c == '{')
+        {
+            elementOpen = e;
+            depth++;
+            continue;
+        }
+        if(c == ':')
+        {
+            colon = index[e];
+            continue;
+        }
+
+        // end of an element
+        size_t separator = index[e];
+        if(elementOpen != npos && index[elementClose] - index[elementOpen] >= cut)
+        {
+            if(elementStart - 1 > runStart)
+            {
+                parts.emplace_back();
+                parts.back().begin = runStart;
+                parts.back().end = elementStart - 1;
+                parts.back().open = npos;
+                parts.back().isMap = isMap;
+            }
+            parts.emplace_back();
+            Part& part = parts.back();
+            part.open = elementOpen;
+            part.close = elementClose;
+            if(colon != npos)
+            {
+                size_t keyStart = text.find('"', elementStart) + 1;
+                size_t keyEnd = text.rfind('"', colon);
+                if(!Escape::isJson(text.substr(keyStart, keyEnd - keyStart)))
+                    throw std::invalid_argument("ParallelReader::parse : invalid JSON escape sequence");
+                Escape::decode(text.substr(keyStart, keyEnd - keyStart), part.key);
+            }
+            runStart = separator + 1;
+        }
+        else if(separator - runStart >= cut || e == close)
+        {
+            parts.emplace_back();
+            parts.back().begin = runStart;
+            parts.back().end = separator;
+            parts.back().open = npos;
+            parts.back().isMap = isMap;
+            runStart = separator + 1;
+        }
+        elementStart = separator + 1;
+        elementOpen = npos;
+        colon = npos;
+    }
+
+    // the parts are complete, their addresses don't change anymore
+    for(size_t i = 0; i < parts.size(); i++)
+        if(parts[i].open != npos)
+            split(parts[i].open, parts[i].close, parts[i].parts);
+}
+
+void ParallelReader::readChunks(std::vector<Part>& parts)
+{
+    // the chunks of all the levels are read by the same pool
+    std::vector<Part*> chunks;
+    std::vector<std::vector<Part>*> levels(1, &parts);
+    while(!levels.empty())
+    {
+        std::vector<Part>* level = levels.back();
+        levels.pop_back();
+        for(size_t i = 0; i < level->size(); i++)
+        {
+            Part& part = (*level)[i];
+            if(part.open == npos)
+                chunks.push_back(&part);
+            else
+                levels.push_back(&part.parts);
+        }
+    }
+
+    std::atomic<size_t> next(0);
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    auto readNext = [&]() {
+        KeyTable keys; // each thread interns the keys of its chunks
+        try {
+            size_t i;
+            while((i = next.fetch_add(1)) < chunks.size())
+            {
+                Part& part = *chunks[i];
+                ChunkBuffer buffer(part.isMap ? '{' : '[', text.substr(part.begin, part.end - part.begin),
+                                   part.isMap ? '}' : ']');
+                std::istream stream(&buffer);
+                JsonReader reader(&stream);
+                reader.setKeyTable(&keys);
+                reader.parse(part.value);
+            }
+        } catch(...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if(!error)
+                error = std::current_exception();
+            next = chunks.size();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    size_t workerCount = threadCount < chunks.size() ? threadCount : chunks.size();
+    for(size_t i = 1; i < workerCount; i++)
+        workers.emplace_back(readNext);
+    readNext();
+    for(size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+    if(error)
+        std::rethrow_exception(error);
+}
+
+void ParallelReader::stitch(size_t open, std::vector<Part>& parts, Variant& result)
+{
+    for(size_t i = 0; i < parts.size(); i++)
+        if(parts[i].open != npos)
+            stitch(parts[i].open, parts[i].parts, parts[i].value);
+
+    if(text[index[open]] == '{')
+    {
+        result.createMap();
+        Variant::MapType& map = result.getMap();
+        for(size_t i = 0; i < parts.size(); i++)
+        {
+            Part& part = parts[i];
+            if(part.open != npos)
+                result.emplace(Key(part.key)) = std::move(part.value);
+            else if(part.value.getType() == Variant::MAP)
+            {
+                // the nodes are moved, and the duplicated keys left in the chunk replace the previous values
+                Variant::MapType& chunk = part.value.getMap();
+                map.merge(chunk);
+                for(Variant::MapType::iterator it = chunk.begin(); it != chunk.end(); ++it)
+                    map.find(it->first)->second = std::move(it->second);
+            }
+        }
+        return;
+    }
+
+    size_t size = 0;
+    for(size_t i = 0; i < parts.size(); i++)
+        size += parts[i].open != npos ? 1 : countElements(parts[i].value);
+
+    // the first chunk is kept as it is, the next elements are appended to it
+    size_t first = 0;
+    if(!parts.empty() && parts[0].open == npos && parts[0].value.getType() == Variant::SEQUENCE)
+    {
+        result = std::move(parts[0].value);
+        first = 1;
+    }
+    else
+        result.createArray();
+    result.reserve(size);
+    ArrayBuilder builder(result);
+    for(size_t i = first; i < parts.size(); i++)
+    {
+        if(parts[i].open != npos)
+            builder.append(std::move(parts[i].value));
+        else
+            builder.appendAll(parts[i].value);
+    }
+}
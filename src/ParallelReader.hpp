@@ -0,0 +1,98 @@
+#ifndef PARALLELREADER_H
+#define PARALLELREADER_H
+
+#include "Variant.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*! \brief Class reading a large JSON document in memory on many threads.
+ *
+ * BasicReader builds the tree in a single recursion, so a document of millions of elements is read by one core.
+ * A ParallelReader first scans the text once to index its structure: the positions of the brackets, braces,
+ * commas and colons outside the strings. The elements of the large arrays and maps are then cut into chunks of
+ * about the same size, found with the index without reading the elements, and the chunks are read by a pool of
+ * threads with JsonReader. Each worker takes the next chunk not read yet, so a slow chunk doesn't delay the
+ * others. The results are finally stitched together in their order in the text.
+ *
+ * An element larger than a chunk (the array of a map at the root for example) is itself cut in chunks, so the
+ * large containers are split at any depth.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * ParallelReader reader;
+ * Variant doc;
+ * reader.parseFile(doc, "dump.json");
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The syntax is strict JSON (see StrictJsonDialect), and the values have the same types as with JsonReader.
+ * The documents smaller than two chunks are read directly by a JsonReader.
+ * \see BasicReader
+ */
+class ParallelReader
+{
+    public:
+        /*! \brief Construct a reader.
+         *
+         * \param threadCount The number of threads reading the chunks, or 0 for one per core.
+         */
+        explicit ParallelReader(unsigned threadCount = 0);
+
+        /*! \brief Set the minimum size of a chunk in bytes (1 MiB by default).
+         */
+        void setChunkSize(size_t size);
+
+        /*! \brief Read the JSON document _text_.
+         *
+         * \throw std::invalid_argument is thrown if the brackets of the document are not balanced, or if a string
+         * is not closed.
+         */
+        void parse(Variant& result, std::string_view text);
+
+        /*! \brief Read the JSON file _file_.
+         *
+         * \throw std::invalid_argument is thrown if the file cannot be opened, or if its structure is invalid.
+         */
+        void parseFile(Variant& result, const std::string& file);
+
+
+
+
+    private:
+        /*! A part of the elements of a container: a run of small elements, or a single large element split again.
+         */
+        struct Part
+        {
+            size_t begin;               //!< Chunk: offset of the first element in the text.
+            size_t end;                 //!< Chunk: offset after the last element.
+            bool isMap;                 //!< Chunk: the elements are the entries of a map.
+            size_t open;                //!< Large element: its opening entry in the index, npos for a chunk.
+            size_t close;               //!< Large element: its closing entry in the index.
+            std::string key;            //!< Large element of a map: its key.
+            Variant value;              //!< The chunk read, or the large element.
+            std::vector<Part> parts;    //!< Large element: its parts.
+        };
+
+        unsigned threadCount;           //!< Number of threads reading the chunks.
+        size_t chunkSize;               //!< Minimum size of a chunk.
+        std::string_view text;          //!< The document being read.
+        std::vector<size_t> index;      //!< Offsets of the structural characters of the document.
+
+
+        /*! Index the structure of the text from _start_ to the end of the root container.
+         */
+        void buildIndex(size_t start);
+
+        /*! Cut the elements of the container between the entries _open_ and _close_ of the index into parts.
+         */
+        void split(size_t open, size_t close, std::vector<Part>& parts);
+
+        /*! Read the chunks of _parts_ and of their large elements.
+         */
+        void readChunks(std::vector<Part>& parts);
+
+        /*! Assemble the parts of the container between the entries _open_ and _close_ in _result_.
+         */
+        void stitch(size_t open, std::vector<Part>& parts, Variant& result);
+};
+
+#endif // PARALLELREADER_H
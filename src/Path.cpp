@@ -0,0 +1,433 @@
+#include "Path.hpp"
+#include "Shape.hpp"
+#include <stdexcept>
+#include <cstdlib>
+#include <cctype>
+
+namespace
+{
+    /*! Get the index written in _token_, or -1 if it is not a canonical array index.
+     */
+    long arrayIndex(std::string_view token)
+    {
+        if(token.empty() || token.size() > 18 || (token[0] == '0' && token.size() > 1))
+            return -1;
+        long index = 0;
+        for(size_t i = 0; i < token.size(); i++)
+        {
+            if(!isdigit(static_cast<unsigned char>(token[i])))
+                return -1;
+            index = index * 10 + (token[i] - '0');
+        }
+        return index;
+    }
+
+    bool isNumber(Variant::VariantType type)
+    {
+        return type==Variant::CHAR || type==Variant::INT || type==Variant::UINT || type==Variant::LONG ||
+               type==Variant::ULONG || type==Variant::FLOAT || type==Variant::DOUBLE;
+    }
+
+    bool isInteger(Variant::VariantType type) {
+        return isNumber(type) && type!=Variant::FLOAT && type!=Variant::DOUBLE; }
+
+    long long integer(const Variant& v) {
+        return v.getType()==Variant::INT || v.getType()==Variant::CHAR ? v.toInt() : v.toLong(); }
+
+    double real(const Variant& v)
+    {
+        if(v.getType()==Variant::FLOAT)
+            return v.toFloat();
+        if(v.getType()==Variant::DOUBLE)
+            return v.toDouble();
+        return static_cast<double>(integer(v));
+    }
+
+    /*! Compare two values of the same kind: negative, zero or positive like strcmp.
+     *  Returns false in _comparable_ if the values have different kinds.
+     */
+    int compareValues(const Variant& a, const Variant& b, bool& ordered, bool& comparable)
+    {
+        comparable = true;
+        ordered = true;
+        if(isNumber(a.getType()) && isNumber(b.getType()))
+        {
+            if(isInteger(a.getType()) && isInteger(b.getType()))
+            {
+                long long x = integer(a), y = integer(b);
+                return x < y ? -1 : (x > y ? 1 : 0);
+            }
+            double x = real(a), y = real(b);
+            return x < y ? -1 : (x > y ? 1 : 0);
+        }
+        if(a.getType()==Variant::STRING && b.getType()==Variant::STRING)
+            return a.toString().compare(b.toString());
+
+        ordered = false;
+        if(a.getType()==Variant::BOOL && b.getType()==Variant::BOOL)
+            return a.toBool() == b.toBool() ? 0 : 1;
+        if(a.getType()==Variant::NULLTYPE && b.getType()==Variant::NULLTYPE)
+            return 0;
+        comparable = false;
+        return 1;
+    }
+
+    /*! Call _f_ on each element of an array or each value of a map, until it returns true.
+     *  A const value is only read, a non-const one is converted to a regular array or map so its children can
+     *  be modified.
+     */
+    template<class V, class Function>
+    bool forEachChild(V& value, Function f)
+    {
+        if(value.getType()==Variant::SEQUENCE)
+        {
+            // by index: a const packed array builds the blocks of elements visited, not a copy of the array
+            for(size_t i = 0; i < value.size(); i++)
+                if(f(value[i]))
+                    return true;
+        }
+        else if(value.getType()==Variant::MAP)
+        {
+            auto& map = value.getMap();
+            for(auto it = map.begin(); it != map.end(); ++it)
+                if(f(it->second))
+                    return true;
+        }
+        return false;
+    }
+}
+
+
+//******************************** Constructors *******************************//
+Path::Path(std::string_view expression) :
+    expression(expression)
+{
+    if(expression.empty() || expression[0] == '/')
+        compilePointer();
+    else if(expression[0] == '$')
+        compileJsonPath();
+    else
+        throw std::invalid_argument("Path::Path : an expression starts with '/' or '$'");
+}
+
+
+//****************************** Public functions *******************************//
+const std::string& Path::getExpression() const {
+    return expression; }
+
+bool Path::isSingular() const
+{
+    for(size_t i = 0; i < steps.size(); i++)
+        if(steps[i].kind != Step::MEMBER && steps[i].kind != Step::INDEX)
+            return false;
+    return true;
+}
+
+const Variant* Path::find(const Variant& root) const
+{
+    return visit<const Variant>(steps, 0, root, 0);
+}
+
+Variant* Path::find(Variant& root) const
+{
+    return visit<Variant>(steps, 0, root, 0);
+}
+
+size_t Path::evaluate(const Variant& root, std::vector<const Variant*>& results) const
+{
+    size_t before = results.size();
+    visit<const Variant>(steps, 0, root, &results);
+    return results.size() - before;
+}
+
+
+//****************************** Private functions *******************************//
+void Path::compilePointer()
+{
+    std::string_view e = expression;
+    size_t pos = 0;
+    while(pos < e.size())
+    {
+        size_t end = e.find('/', pos + 1);
+        std::string_view token = e.substr(pos + 1, end == std::string_view::npos ? end : end - pos - 1);
+
+        Step step(Step::MEMBER);
+        for(size_t i = 0; i < token.size(); i++)
+        {
+            if(token[i] != '~')
+                step.key.push_back(token[i]);
+            else if(i + 1 < token.size() && (token[i+1] == '0' || token[i+1] == '1'))
+                step.key.push_back(token[++i] == '0' ? '~' : '/');
+            else
+                throw std::invalid_argument("Path::Path : invalid escape in JSON Pointer");
+        }
+        step.index = arrayIndex(step.key);
+        steps.push_back(step);
+        pos = end;
+    }
+}
+
+void Path::compileJsonPath()
+{
+    const std::string& e = expression;
+    size_t pos = 1;
+
+    // helpers reading the expression at _pos_
+    auto fail = [](const char* msg) {
+        throw std::invalid_argument(std::string("Path::Path : ") + msg); };
+    auto skipSpaces = [&]() {
+        while(pos < e.size() && (e[pos] == ' ' || e[pos] == '\t'))
+            pos++;
+    };
+    auto readName = [&]() {
+        size_t start = pos;
+        while(pos < e.size() && std::string_view(".[]()=!<> \t").find(e[pos]) == std::string_view::npos)
+            pos++;
+        if(pos == start)
+            fail("missing key");
+        return e.substr(start, pos - start);
+    };
+    auto readQuoted = [&]() {
+        char quote = e[pos++];
+        std::string result;
+        while(pos < e.size() && e[pos] != quote)
+        {
+            if(e[pos] == '\\' && pos + 1 < e.size())
+                pos++;
+            result.push_back(e[pos++]);
+        }
+        if(pos >= e.size())
+            fail("unterminated string");
+        pos++;
+        return result;
+    };
+    auto readIndex = [&]() {
+        const char* begin = e.c_str() + pos;
+        char* end;
+        long index = std::strtol(begin, &end, 10);
+        if(end == begin)
+            fail("invalid index");
+        pos += end - begin;
+        return index;
+    };
+    auto expect = [&](char c) {
+        skipSpaces();
+        if(pos >= e.size() || e[pos] != c)
+            fail("unexpected character");
+        pos++;
+    };
+
+    // a step of a filter: .name ['name'] [n]
+    auto readSimpleStep = [&](std::vector<Step>& out) {
+        if(e[pos] == '.')
+        {
+            pos++;
+            Step step(Step::MEMBER);
+            step.key = readName();
+            out.push_back(step);
+            return;
+        }
+        expect('[');
+        skipSpaces();
+        if(pos < e.size() && (e[pos] == '\'' || e[pos] == '"'))
+        {
+            Step step(Step::MEMBER);
+            step.key = readQuoted();
+            out.push_back(step);
+        }
+        else
+        {
+            Step step(Step::INDEX);
+            step.index = readIndex();
+            out.push_back(step);
+        }
+        expect(']');
+    };
+
+    // a filter, after '[?'
+    auto readFilter = [&]() {
+        expect('(');
+        expect('@');
+        Step step(Step::FILTER);
+        while(pos < e.size() && (e[pos] == '.' || e[pos] == '['))
+            readSimpleStep(step.relative);
+        skipSpaces();
+
+        static const char* operators[] = { "==", "!=", "<=", ">=", "<", ">" };
+        static const Comparison comparisons[] = { EQUAL, NOT_EQUAL, LESS_EQUAL, GREATER_EQUAL, LESS, GREATER };
+        for(size_t i = 0; i < 6 && step.comparison == EXISTS; i++)
+        {
+            size_t length = std::char_traits<char>::length(operators[i]);
+            if(e.compare(pos, length, operators[i]) == 0)
+            {
+                step.comparison = comparisons[i];
+                pos += length;
+            }
+        }
+        if(step.comparison != EXISTS)
+        {
+            skipSpaces();
+            if(pos < e.size() && (e[pos] == '\'' || e[pos] == '"'))
+                step.value = readQuoted();
+            else
+            {
+                std::string literal = readName();
+                if(literal == "true" || literal == "false")
+                    step.value = literal == "true";
+                else if(literal == "null")
+                    step.value.setToNull();
+                else
+                {
+                    // the name stops at '.', read the rest of a real number
+                    while(pos < e.size() && (isdigit(static_cast<unsigned char>(e[pos])) ||
+                                             std::string_view(".eE+-").find(e[pos]) != std::string_view::npos))
+                        literal.push_back(e[pos++]);
+                    char* end;
+                    if(literal.find_first_of(".eE") == std::string::npos)
+                        step.value = static_cast<long long>(std::strtoll(literal.c_str(), &end, 10));
+                    else
+                        step.value = std::strtod(literal.c_str(), &end);
+                    if(*end != '\0')
+                        fail("invalid value in filter");
+                }
+            }
+        }
+        expect(')');
+        expect(']');
+        steps.push_back(step);
+    };
+
+    while(pos < e.size())
+    {
+        if(e.compare(pos, 2, "..") == 0)
+        {
+            pos += 2;
+            Step step(Step::DESCENDANT);
+            if(pos < e.size() && e[pos] == '*')
+                pos++;
+            else
+                step.key = readName();
+            steps.push_back(step);
+        }
+        else if(e.compare(pos, 2, ".*") == 0)
+        {
+            pos += 2;
+            steps.push_back(Step(Step::WILDCARD));
+        }
+        else if(e[pos] == '[')
+        {
+            size_t bracket = pos++;
+            skipSpaces();
+            if(pos < e.size() && e[pos] == '*')
+            {
+                pos++;
+                expect(']');
+                steps.push_back(Step(Step::WILDCARD));
+            }
+            else if(pos < e.size() && e[pos] == '?')
+            {
+                pos++;
+                readFilter();
+            }
+            else
+            {
+                pos = bracket;
+                readSimpleStep(steps);
+            }
+        }
+        else
+            readSimpleStep(steps);
+    }
+}
+
+template<class V>
+V* Path::visit(const std::vector<Step>& steps, size_t i, V& value, std::vector<V*>* results)
+{
+    if(i == steps.size())
+    {
+        if(!results)
+            return &value;
+        results->push_back(&value);
+        return 0;
+    }
+
+    const Step& step = steps[i];
+    V* found = 0;
+    switch(step.kind)
+    {
+        case Step::MEMBER:
+            if(V* member = value.find(step.key))
+                return visit(steps, i + 1, *member, results);
+            if(step.index >= 0 && value.getType()==Variant::SEQUENCE && static_cast<size_t>(step.index) < value.size())
+                return visit(steps, i + 1, value[step.index], results);
+            break;
+        case Step::INDEX:
+            if(value.getType()==Variant::SEQUENCE)
+            {
+                long index = step.index < 0 ? static_cast<long>(value.size()) + step.index : step.index;
+                if(index >= 0 && static_cast<size_t>(index) < value.size())
+                    return visit(steps, i + 1, value[index], results);
+            }
+            break;
+        case Step::WILDCARD:
+            forEachChild(value, [&](V& child) {
+                found = visit(steps, i + 1, child, results);
+                return found != 0;
+            });
+            break;
+        case Step::DESCENDANT:
+            return visitDescendants(steps, i, value, results);
+        case Step::FILTER:
+            forEachChild(value, [&](V& child) {
+                if(accept(step, child))
+                    found = visit(steps, i + 1, child, results);
+                return found != 0;
+            });
+            break;
+    }
+    return found;
+}
+
+template<class V>
+V* Path::visitDescendants(const std::vector<Step>& steps, size_t i, V& value, std::vector<V*>* results)
+{
+    const std::string& key = steps[i].key;
+    V* found = 0;
+    if(!key.empty())
+    {
+        if(V* member = value.find(key))
+            if((found = visit(steps, i + 1, *member, results)))
+                return found;
+    }
+    forEachChild(value, [&](V& child) {
+        if(key.empty())
+            found = visit(steps, i + 1, child, results);
+        if(!found)
+            found = visitDescendants(steps, i, child, results);
+        return found != 0;
+    });
+    return found;
+}
+
+template const Variant* Path::visit(const std::vector<Step>&, size_t, const Variant&, std::vector<const Variant*>*);
+template Variant* Path::visit(const std::vector<Step>&, size_t, Variant&, std::vector<Variant*>*);
+
+bool Path::accept(const Step& step, const Variant& element)
+{
+    const Variant* v = visit<const Variant>(step.relative, 0, element, 0);
+    if(step.comparison == EXISTS || !v)
+        return v != 0;
+
+    bool ordered, comparable;
+    int cmp = compareValues(*v, step.value, ordered, comparable);
+    switch(step.comparison)
+    {
+        case EQUAL:         return comparable && cmp == 0;
+        case NOT_EQUAL:     return !comparable || cmp != 0;
+        case LESS:          return ordered && cmp < 0;
+        case LESS_EQUAL:    return ordered && cmp <= 0;
+        case GREATER:       return ordered && cmp > 0;
+        case GREATER_EQUAL: return ordered && cmp >= 0;
+        default:            return false;
+    }
+}
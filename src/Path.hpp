@@ -0,0 +1,206 @@
+#ifndef PATH_H
+#define PATH_H
+
+#include "Variant.hpp"
+#include "Reader.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*! \brief Class containing a compiled path expression, evaluated on Variant trees or directly on a reader.
+ *
+ * Two syntaxes are accepted:
+ *  - JSON Pointer (RFC 6901): an empty string for the root, or <pre> /routes/0/target </pre>. The escapes
+ *    <pre> ~0 </pre> and <pre> ~1 </pre> stand for <pre> ~ </pre> and <pre> / </pre>.
+ *  - A subset of JSONPath, starting with <pre> $ </pre>:
+ *     - <pre> .name </pre> or <pre> ['name'] </pre>: the value of a key.
+ *     - <pre> [2] </pre>: an element of an array. A negative index counts from the end.
+ *     - <pre> .* </pre> or <pre> [*] </pre>: all the elements of an array or a map.
+ *     - <pre> ..name </pre> or <pre> ..* </pre>: the values of a key (or all the values) at any depth.
+ *     - <pre> [?(@.port > 1024)] </pre>: the elements for which a comparison is true. The operators are
+ *       <pre> == != < <= > >= </pre>, the values are numbers, strings, true, false and null. <pre> [?(@.port)] </pre>
+ *       keeps the elements having the key.
+ *
+ * The expression is compiled once by the constructor, and the evaluation never throws: a missing key or a value
+ * of the wrong type just doesn't match.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * static const Path target("/routes/0/target");
+ * if(const Variant* t = target.find(message))
+ *     forward(t->toString());
+ *
+ * static const Path hosts("$.servers[?(@.enabled == true)].host");
+ * std::vector<const Variant*> found;
+ * hosts.evaluate(config, found);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * select() evaluates the path while reading a document: only the matching values are built, the other subtrees
+ * are skipped by the reader.
+ * \see Variant, BasicReader
+ */
+class Path
+{
+    public:
+        /*! \brief Compile a JSON Pointer (empty or starting with '/') or a JSONPath expression (starting with '$').
+         * \throw std::invalid_argument is thrown if the expression is not valid.
+         */
+        explicit Path(std::string_view expression);
+
+        /*! \brief Get the source expression.
+         */
+        const std::string& getExpression() const;
+
+        /*! \brief Check if the path can match at most one value (no wildcard, descendant or filter).
+         */
+        bool isSingular() const;
+
+        /*! \brief Get the first value matching the path in _root_.
+         *
+         * _root_ is only read. The pointer is valid while the tree is not modified: a non-const access can convert
+         * a packed array or a shaped map, or drop the read-only copy of its elements the pointer refers to.
+         * \return The value, or a null pointer if nothing matches.
+         */
+        const Variant* find(const Variant& root) const;
+
+        /*! \brief Get the first value matching the path in _root_, to modify it.
+         *
+         * The packed arrays and the shaped maps iterated or indexed on the way are converted to regular arrays and
+         * maps, so the value returned is stored in the tree itself.
+         * \return The value, or a null pointer if nothing matches.
+         */
+        Variant* find(Variant& root) const;
+
+        /*! \brief Append all the values matching the path in _root_ to _results_, in document order.
+         *
+         * The pointers follow the same rules as the ones returned by find(const Variant&).
+         * \return The number of values appended.
+         */
+        size_t evaluate(const Variant& root, std::vector<const Variant*>& results) const;
+
+        /*! \brief Read the next document of _reader_, and append the values matching the path to _results_.
+         *
+         * The keys, indexes and wildcards are evaluated while reading: the subtrees which can't match are skipped
+         * without building them. From the first filter or descendant step, the value is read in a Variant and the
+         * end of the path is evaluated on it.
+         * \return false if the end of the stream is reached before any new document, true otherwise.
+         * \see BasicReader::beginDocument()
+         */
+        template<class Dialect>
+        bool select(BasicReader<Dialect>& reader, std::vector<Variant>& results) const;
+
+
+
+
+    private:
+        /*! Comparison of a filter.
+         */
+        enum Comparison { EXISTS, EQUAL, NOT_EQUAL, LESS, LESS_EQUAL, GREATER, GREATER_EQUAL };
+
+        /*! A step of the path.
+         */
+        struct Step
+        {
+            enum Kind { MEMBER, INDEX, WILDCARD, DESCENDANT, FILTER } kind;
+            std::string key;            //!< MEMBER and DESCENDANT: the key (DESCENDANT: empty for all the values).
+            long index;                 //!< INDEX: the index. MEMBER: the key as an array index, or -1.
+            std::vector<Step> relative; //!< FILTER: the path of the value compared, from the element.
+            Comparison comparison;      //!< FILTER: the comparison.
+            Variant value;              //!< FILTER: the value compared.
+
+            Step(Kind kind) : kind(kind), index(-1), comparison(EXISTS) {}
+        };
+
+        std::string expression;     //!< The source expression.
+        std::vector<Step> steps;    //!< The compiled steps.
+
+
+        /*! Compile a JSON Pointer.
+         */
+        void compilePointer();
+
+        /*! Compile a JSONPath expression.
+         */
+        void compileJsonPath();
+
+        /*! Evaluate _steps_ from the step _i_ on _value_. If _results_ is null, stop at the first match and return
+         *  it, otherwise append all the matches and return null. _V_ is Variant or const Variant, instantiated in
+         *  Path.cpp.
+         */
+        template<class V>
+        static V* visit(const std::vector<Step>& steps, size_t i, V& value, std::vector<V*>* results);
+
+        /*! Visit _value_ and all its descendants for the step DESCENDANT _i_.
+         */
+        template<class V>
+        static V* visitDescendants(const std::vector<Step>& steps, size_t i, V& value, std::vector<V*>* results);
+
+        /*! Check if the filter _step_ accepts _element_.
+         */
+        static bool accept(const Step& step, const Variant& element);
+
+        /*! Evaluate the path from the step _i_ at the current value position of _reader_.
+         */
+        template<class Dialect>
+        void selectValue(BasicReader<Dialect>& reader, size_t i, std::string& key, std::vector<Variant>& results) const;
+};
+
+
+//****************************** Templates *******************************//
+template<class Dialect>
+bool Path::select(BasicReader<Dialect>& reader, std::vector<Variant>& results) const
+{
+    if(!reader.beginDocument())
+        return false;
+    std::string key;
+    selectValue(reader, 0, key, results);
+    return true;
+}
+
+template<class Dialect>
+void Path::selectValue(BasicReader<Dialect>& reader, size_t i, std::string& key, std::vector<Variant>& results) const
+{
+    if(i == steps.size())
+    {
+        results.emplace_back();
+        reader.readVariant(results.back());
+        return;
+    }
+
+    const Step& step = steps[i];
+    if(step.kind == Step::MEMBER || step.kind == Step::WILDCARD || (step.kind == Step::INDEX && step.index >= 0))
+    {
+        if(step.kind != Step::INDEX && reader.enterMap())
+        {
+            while(reader.nextKey(key))
+            {
+                if(step.kind == Step::WILDCARD || key == step.key)
+                    selectValue(reader, i + 1, key, results);
+                else
+                    reader.skipValue();
+            }
+        }
+        else if((step.index >= 0 || step.kind == Step::WILDCARD) && reader.enterArray())
+        {
+            for(long n = 0; reader.nextItem(); n++)
+            {
+                if(step.kind == Step::WILDCARD || n == step.index)
+                    selectValue(reader, i + 1, key, results);
+                else
+                    reader.skipValue();
+            }
+        }
+        else
+            reader.skipValue();
+        return;
+    }
+
+    // the end of the path needs the whole value
+    Variant value;
+    reader.readVariant(value);
+    std::vector<const Variant*> found;
+    visit<const Variant>(steps, i, value, &found);
+    for(size_t n = 0; n < found.size(); n++)
+        results.push_back(*found[n]);
+}
+
+#endif // PATH_H
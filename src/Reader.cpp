@@ -1,4 +1,7 @@
 #include "Reader.hpp"
+#include "Escape.hpp"
+#include "Shape.hpp"
+#include "VariantPool.hpp"
 #include <stdexcept>
 #include <cctype>
 #include <cstring>
@@ -7,27 +10,39 @@
 #include <sstream>
 #include <limits>
 
-void Reader::parseFile(Variant &result, std::string file)
+template<class Dialect>
+void BasicReader<Dialect>::parseFile(Variant &result, std::string file)
 {
     std::ifstream strm(file.c_str());
     if(!strm.is_open())
 		throw std::invalid_argument("Reader::parseFile : Cannot open file");
-    Reader reader(&strm);
+    BasicReader reader(&strm);
     reader.parse(result);
 }
 
-void Reader::parseString(Variant &result, std::string text)
+template<class Dialect>
+void BasicReader<Dialect>::parseString(Variant &result, std::string text)
 {
     std::istringstream strm(text);
-    Reader reader(&strm);
+    BasicReader reader(&strm);
     reader.parse(result);
 }
 
 
 //******************************** Constructors *******************************//
-Reader::Reader(std::istream* input)
+template<class Dialect>
+BasicReader<Dialect>::BasicReader(std::istream* input) :
+    validated(0)
 {
+    nbErrors = 0;
     comment = '\0';
+    started = false;
+    ended = false;
+    delimited = false;
+    arrayDepth = 0;
+    keys = &ownKeys;
+    pool = 0;
+    validation = false;
     ifs = 0;
     if(!input->good())
         throw std::logic_error("Reader::Reader : stream error");
@@ -36,57 +51,347 @@ Reader::Reader(std::istream* input)
 
 
 //****************************** Public functions *******************************//
-void Reader::setStream(std::istream* input)
+template<class Dialect>
+void BasicReader<Dialect>::setStream(std::istream* input)
 {
+    started = false;
     ifs = 0;
     if(!input->good())
         throw std::logic_error("Reader::Reader : stream error");
-    ifs = input;
+    bindStream(input);
+}
+
+template<class Dialect>
+void BasicReader<Dialect>::setValidation(bool validate)
+{
+    if(validate == validation)
+        return;
+    validation = validate;
+    if(ifs == &validated)
+        validator->setValidation(validate);
+    else if(ifs)
+        bindStream(ifs);
+}
+
+template<class Dialect>
+void BasicReader<Dialect>::setKeyTable(KeyTable* table)
+{
+    keys = table;
 }
 
-void Reader::parse(Variant &result)
+template<class Dialect>
+void BasicReader<Dialect>::setPool(VariantPool* valuePool)
+{
+    pool = valuePool;
+}
+
+template<class Dialect>
+void BasicReader<Dialect>::parse(Variant &result)
 {
     if(ifs == 0 || ifs->fail())
         throw std::logic_error("Reader::Reader : stream error");
     *ifs >> std::noskipws;
 
-    result.createMap();
-    std::string key;
-    for(nextChar(); !ifs->eof(); nextChar())
+    if(!Dialect::rootMap)
+    {
+        started = false;
+        if(!next(result))
+            result.setToNull();
+        if(Dialect::strictSyntax)
+        {
+            // only blanks may follow the root value, a closing bracket or delimiter eaten by endValue included
+            skipBlanks();
+            if(ended || delimited || !ifs->eof())
+                syntaxError("Reader::parse");
+        }
+        return;
+    }
+
+    if(pool)
+        pool->createMap(result);
+    else
+        result.createMap();
+    std::string& key = keyBuf;
+    arrayDepth = 0;
+    nextChar();
+    while(!ifs->eof())
+    {
+        readKey(key);
+        if(isValueDelimiter(charBuf) || charBuf=='}')
+        {
+            nextChar();
+            continue;
+        }
+        if(ifs->eof())
+            break;
+        readValue(&insertKey(&result, key));
+    }
+}
+
+template<class Dialect>
+bool BasicReader<Dialect>::next(Variant &result)
+{
+    if(!beginDocument())
+        return false;
+
+    if(pool)
+        pool->release(result);
+    else
+        result.setToNull();
+    if(charBuf == '[')
+        readArray(&result);
+    else if(charBuf == '{')
+        readMap(&result);
+    else
+    {
+        // a single value ends at the first blank
+        std::string& str = strBuf;
+        bool isString = false;
+        str.clear();
+        for( ;!isBlank(charBuf) && !isValueDelimiter(charBuf) &&
+              charBuf!='[' && charBuf!='{' && !ifs->eof(); nextChar())
+        {
+            if(Dialect::strictSyntax && (isString || ((charBuf=='\"' || charBuf=='\'') && !str.empty())))
+                syntaxError("Reader::next"); // a string is a whole token
+            if(charBuf=='\"' || (Dialect::singleQuotes && charBuf=='\''))
+            {
+                readString(str,charBuf,charBuf=='\"');
+                isString = true;
+            }
+            else if(goodChar(charBuf))
+                str.push_back(charBuf);
+            else
+                syntaxError("Reader::next");
+        }
+        readScalar(&result,str,isString);
+    }
+    return true;
+}
+
+
+//****************************** Pull interface *******************************//
+template<class Dialect>
+bool BasicReader<Dialect>::beginDocument()
+{
+    if(ifs == 0 || (ifs->fail() && !ifs->eof()))
+        throw std::logic_error("Reader::next : stream error");
+    if(!started)
+    {
+        *ifs >> std::noskipws;
+        nextChar();
+        started = true;
+    }
+
+    // separators between documents
+    while((isBlank(charBuf) || charBuf=='\n' || charBuf==',' || charBuf==';') && !ifs->eof())
+        nextChar();
+    ended = false;
+    arrayDepth = 0;
+    return !ifs->eof();
+}
+
+template<class Dialect>
+bool BasicReader<Dialect>::enterMap()
+{
+    skipBlanks();
+    if(charBuf != '{')
+        return false;
+    nextChar();
+    ended = false;
+    delimited = false;
+    return true;
+}
+
+template<class Dialect>
+bool BasicReader<Dialect>::enterArray()
+{
+    skipBlanks();
+    if(charBuf != '[')
+        return false;
+    nextChar();
+    ended = false;
+    delimited = false;
+    return true;
+}
+
+template<class Dialect>
+bool BasicReader<Dialect>::nextKey(std::string& key)
+{
+    if(ended) // the last value was followed by '}'
+    {
+        endValue();
+        return false;
+    }
+    while(true)
     {
         readKey(key);
-        if(charBuf==',' || charBuf==';' || charBuf=='}')
+        if(charBuf=='}' || charBuf==']' || ifs->eof())
+        {
+            if(delimited || !key.empty() || (Dialect::strictSyntax && ifs->eof())) // trailing delimiter, key without value or unclosed map
+                syntaxError("Reader::nextKey");
+            nextChar();
+            endValue();
+            return false;
+        }
+        if(isValueDelimiter(charBuf)) // empty entry
         {
+            syntaxError("Reader::nextKey");
             nextChar();
             continue;
         }
-        readValue(&(result.insert(key,0)));
+        return true;
+    }
+}
+
+template<class Dialect>
+bool BasicReader<Dialect>::nextItem()
+{
+    if(ended) // the last value was followed by ']'
+    {
+        endValue();
+        return false;
+    }
+    while((isBlank(charBuf) || (Dialect::newlineDelimiter && charBuf=='\n')) && !ifs->eof())
+        nextChar();
+    if(charBuf==']' || charBuf=='}' || ifs->eof()) // empty array or trailing delimiter
+    {
+        if(delimited || (Dialect::strictSyntax && ifs->eof())) // unclosed array
+            syntaxError("Reader::nextItem");
+        nextChar();
+        endValue();
+        return false;
+    }
+    return true;
+}
+
+template<class Dialect>
+bool BasicReader<Dialect>::readText(std::string& text, bool& isString)
+{
+    text.clear();
+    isString = false;
+    skipBlanks();
+    if(charBuf == '[' || charBuf == '{')
+    {
+        skipValue();
+        return false;
+    }
+
+    bool closed = false; // strict syntax: the token is ended by a blank or a closing quote
+    for( ;!isValueDelimiter(charBuf) &&
+          charBuf!='}' && charBuf!=']' &&
+          !ifs->eof(); nextChar())
+    {
+        if(Dialect::strictSyntax && closed && !isBlank(charBuf))
+            syntaxError("Reader::readText");
+        if(goodChar(charBuf))
+            text.push_back(charBuf);
+        else if(charBuf=='\"' || (Dialect::singleQuotes && charBuf=='\''))
+        {
+            if(Dialect::strictSyntax && !text.empty())
+                syntaxError("Reader::readText");
+            readString(text,charBuf,charBuf=='\"');
+            isString = true;
+            closed = true;
+        }
+        else if(!isBlank(charBuf))
+            syntaxError("Reader::readText");
+        else if(!text.empty())
+            closed = true;
+    }
+    ended = (charBuf==']' || charBuf=='}');
+    delimited = isValueDelimiter(charBuf);
+    nextChar();
+    return true;
+}
+
+template<class Dialect>
+void BasicReader<Dialect>::readVariant(Variant& value)
+{
+    readValue(&value);
+}
+
+template<class Dialect>
+void BasicReader<Dialect>::skipValue()
+{
+    if(enterMap())
+    {
+        while(nextKey(keyBuf))
+            skipValue();
+    }
+    else if(enterArray())
+    {
+        while(nextItem())
+            skipValue();
+    }
+    else
+    {
+        bool isString;
+        readText(strBuf, isString);
     }
 }
 
 
 //****************************** Private functions *******************************//
-char Reader::nextChar()
+template<class Dialect>
+void BasicReader<Dialect>::bindStream(std::istream* input)
+{
+    ifs = input;
+    if(!validation)
+        return;
+    if(validator)
+        validator->setSource(input->rdbuf());
+    else
+        validator.reset(new TranscodingBuffer(input->rdbuf(), UTF8));
+    validator->setValidation(true);
+    validated.rdbuf(validator.get());
+    validated.exceptions(std::istream::badbit); // forward the validation errors
+    ifs = &validated;
+}
+
+template<class Dialect>
+void BasicReader<Dialect>::syntaxError(const char* function)
+{
+    if(Dialect::strictSyntax)
+        throw std::invalid_argument(std::string(function) + " : invalid JSON syntax");
+    nbErrors++;
+}
+
+template<class Dialect>
+char BasicReader<Dialect>::nextChar()
 {
     charBuf = ifs->get();
     if(ifs->eof())
     {
         charBuf = ' ';
     }
-    else if(std::isspace(charBuf))
+    else if(std::isspace(static_cast<unsigned char>(charBuf)))
     {
-        *ifs >> std::ws;
-        charBuf = ' ';
+        if(Dialect::newlineDelimiter)
+        {
+            bool newline = charBuf == '\n';
+            while(std::isspace(ifs->peek()))
+                newline = (ifs->get() == '\n') || newline;
+            charBuf = newline ? '\n' : ' ';
+        }
+        else
+        {
+            *ifs >> std::ws;
+            charBuf = ' ';
+        }
     }
-    else if(charBuf == '/')
+    else if((Dialect::lineComments || Dialect::blockComments) && charBuf == '/')
     {
         switch(ifs->peek())
         {
             case '/':
+                if(!Dialect::lineComments)
+                    break;
                 ifs->ignore(std::numeric_limits<std::streamsize>::max(),'\n');
-                charBuf = ' ';
+                charBuf = Dialect::newlineDelimiter ? '\n' : ' ';
                 break;
             case '*':
+                if(!Dialect::blockComments)
+                    break;
                 ifs->get();
                 do
                 {
@@ -99,229 +404,220 @@ char Reader::nextChar()
                 break;
         }
     }
-    else if(comment != '\0' && charBuf == comment)
+    else if((Dialect::hashComments && charBuf == '#') ||
+            (Dialect::customComment && comment != '\0' && charBuf == comment))
     {
         ifs->ignore(std::numeric_limits<std::streamsize>::max(),'\n');
-        charBuf = ' ';
+        charBuf = Dialect::newlineDelimiter ? '\n' : ' ';
     }
     return charBuf;
 }
 
-bool Reader::goodChar(char c) const
+template<class Dialect>
+bool BasicReader<Dialect>::goodChar(char c) const
 {
-    return std::isalnum(c) || c == '_' || c=='.' || c=='+' || c=='-';
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c=='.' || c=='+' || c=='-';
 }
 
-void Reader::readMap(Variant* vmap)
+template<class Dialect>
+bool BasicReader<Dialect>::isBlank(char c) const
 {
-    std::string key;
-    Variant* v = 0;
-    nextChar();
-    vmap->createMap();
-    do
-    {
-        readKey(key);
-        if(charBuf=='}' || ifs->eof())
-        {
-            nextChar();
-            break;
-        }
-        if(charBuf==',' || charBuf==';')
-        {
-            nextChar();
-            v = 0;
-            continue;
-        }
-        v = &(vmap->insert(key,0));
-    } while(readValue(v)); // on sort avec le caractere apres : ]}
+    return c == ' ' || (Dialect::newlineDelimiter && c == '\n');
 }
 
-void Reader::readArray(Variant* varray)
+template<class Dialect>
+bool BasicReader<Dialect>::isKeyDelimiter(char c) const
 {
-    Variant* v = 0;
-    nextChar();
-    varray->createArray();
-    do
+    return c == ':' || (Dialect::equalKeyDelimiter && c == '=');
+}
+
+template<class Dialect>
+bool BasicReader<Dialect>::isValueDelimiter(char c) const
+{
+    return c == ',' || (Dialect::semicolonDelimiter && c == ';') || (Dialect::newlineDelimiter && c == '\n');
+}
+
+template<class Dialect>
+void BasicReader<Dialect>::readMap(Variant* vmap)
+{
+    std::string& key = keyBuf;
+    enterMap();
+    if(pool)
+        pool->createMap(*vmap);
+    else
+        vmap->createMap();
+    while(nextKey(key))
+        readValue(&insertKey(vmap, key));
+}
+
+template<class Dialect>
+Variant& BasicReader<Dialect>::insertKey(Variant* vmap, const std::string& key)
+{
+    if(pool)
+        return pool->emplace(*vmap, keys ? keys->intern(key) : Key(key));
+    if(keys)
+        return vmap->emplace(keys->intern(key));
+    return vmap->emplace(key);
+}
+
+template<class Dialect>
+void BasicReader<Dialect>::readArray(Variant* varray)
+{
+    // the arrays at the same depth have often the same size (records, points...)
+    size_t depth = arrayDepth++;
+    if(depth >= sizeHints.size())
+        sizeHints.resize(depth + 1, 0);
+
+    enterArray();
+    if(pool)
+        pool->createArray(*varray);
+    else
+        varray->createArray();
+    varray->reserve(sizeHints[depth]);
+    ArrayBuilder builder(*varray, pool);
+    Variant item;
+    while(nextItem())
     {
-        v = &(varray->insert(0));
-    } while(readValue(v)); // on sort avec le caractere apres : ]}
+        // the numbers are packed and the records share their keys
+        readValue(&item);
+        builder.append(std::move(item));
+    }
+
+    sizeHints[depth] = varray->size();
+    arrayDepth--;
 }
 
 // on sort avec le caractere apres : =:
 // ou avec le caractere chelou si exception
-void Reader::readKey(std::string& key)
+template<class Dialect>
+void BasicReader<Dialect>::readKey(std::string& key)
 {
     key.clear();
-    for( ;charBuf!=':' && charBuf!='=' &&
-          charBuf!=',' && charBuf!=';' &&
+    for( ;!isKeyDelimiter(charBuf) && !isValueDelimiter(charBuf) &&
           charBuf!='[' && charBuf!='{' &&
           charBuf!='}' && !ifs->eof(); nextChar())
     {
-        if(charBuf=='\"' || charBuf=='\'')
-            key = readString(charBuf,charBuf=='\"');
-        else if(goodChar(charBuf))
+        if(charBuf=='\"' || (Dialect::singleQuotes && charBuf=='\''))
+        {
+            key.clear();
+            readString(key,charBuf,charBuf=='\"');
+        }
+        else if(Dialect::unquotedKeys && goodChar(charBuf))
             key.push_back(charBuf);
-        else if(charBuf!=' ')
-            nbErrors++;
+        else if(!isBlank(charBuf))
+            syntaxError("Reader::readKey");
     }
 
-    if(charBuf==':' || charBuf=='=')
+    if(isKeyDelimiter(charBuf))
         nextChar();
+    else if(Dialect::strictSyntax && (charBuf=='[' || charBuf=='{'))
+        syntaxError("Reader::readKey");
     if(ifs->eof())
-        key = "";
+        key.clear();
 }
 
-bool Reader::readValue(Variant* exp)
+template<class Dialect>
+void BasicReader<Dialect>::skipBlanks()
 {
-    if(exp==0)
-        return true;
-    exp->setToNull();
-    std::string str;
-    bool isString = false;
+    while(isBlank(charBuf) && !ifs->eof())
+        nextChar();
+}
 
+template<class Dialect>
+void BasicReader<Dialect>::endValue()
+{
+    skipBlanks();
+    ended = false;
+    delimited = isValueDelimiter(charBuf);
+    if(delimited)
+        nextChar();
+    else if(charBuf==']' || charBuf=='}')
+    {
+        nextChar();
+        ended = true;
+    }
+}
+
+template<class Dialect>
+bool BasicReader<Dialect>::readValue(Variant* exp)
+{
+    if(pool)
+        pool->release(*exp);
+    else
+        exp->setToNull();
+    skipBlanks();
 	if(charBuf == '[')
-	{
 		readArray(exp);
-		return true;
-	}
-	if(charBuf == '{')
-	{
+	else if(charBuf == '{')
 		readMap(exp);
-		return true;
-	}
-
-    for( ;charBuf!=',' && charBuf!=';' &&
-          charBuf!='}' && charBuf!=']' &&
-          !ifs->eof(); nextChar())
+    else
     {
-        if(goodChar(charBuf))
-            str.push_back(charBuf);
-        else switch(charBuf)
-        {
-            case '\"':
-            case '\'':
-                str.append(readString(charBuf,charBuf=='\"'));
-                isString = true;
-				break;
-            default:
-                if(charBuf!=' ')
-                    nbErrors++;
-        }
+        std::string& str = strBuf;
+        bool isString;
+        readText(str,isString);
+        readScalar(exp,str,isString);
     }
+    return !ended;
+}
 
+template<class Dialect>
+void BasicReader<Dialect>::readScalar(Variant* exp, std::string& str, bool isString) const
+{
     // TODO:
     // traiter la string
     if(!isString && (isdigit(str[0]) || str[0]=='+' || str[0]=='-' || str[0]=='.'))
         readNumber(exp,str);
+    else if(Dialect::strictSyntax && !isString && str != "null" && str != "true" && str != "false")
+        throw std::invalid_argument("Reader::readScalar : invalid JSON value");
     else
     {
-        if(str.empty() || str == "null")
+        if(isString && pool)
+            pool->assign(*exp, str);
+        else if(isString)
+            *exp = str;
+        else if(str.empty() || str == "null")
             exp->setToNull();
         else if(str == "true")
             *exp = true;
         else if(str == "false")
             *exp = false;
+        else if(pool)
+            pool->assign(*exp, str);
         else
             *exp = str;
     }
-
-    if(charBuf==']' || charBuf=='}')
-    {
-        nextChar();
-        return false;
-    }
-    else
-    {
-        nextChar();
-        return true;
-    }
-}
-
-std::string utf8Convert(unsigned int hex)
-{
-    std::string result;
-    if(hex <= 0x7F) // 1 byte
-    {
-        result.push_back(hex); // 0b 0xxx xxxx
-    }
-    else if(hex <= 0x7FF) // 2 byte
-    {
-        result.push_back((hex>>6) + 192); // 0b 110x xxxx
-        result.push_back((hex%0x40) + 128); // 0b 10xx xxxx
-    }
-    else if(hex <= 0xFFFF) // 3 byte
-    {
-        result.push_back((hex>>12) + 224); // 0b 1110 xxxx
-        result.push_back((hex>>6)%0x40 + 128); // 0b 10xx xxxx
-        result.push_back((hex%0x40) + 128); // 0b 10xx xxxx
-    }
-    else if(hex <= 0x1FFFFF) // 4 byte
-    {
-        result.push_back((hex>>18) + 240); // 0b 1111 0xxx
-        result.push_back((hex>>12)%0x40 + 128); // 0b 10xx xxxx
-        result.push_back((hex>>6)%0x40 + 128); // 0b 10xx xxxx
-        result.push_back((hex%0x40) + 128); // 0b 10xx xxxx
-    }
-    return result;
 }
 
 // on entre apres : "'
 // on sort avec : "'
-std::string Reader::readString(char endChar, bool escape) const
+template<class Dialect>
+void BasicReader<Dialect>::readString(std::string& result, char endChar, bool escape)
 {
-    std::string result;
-    for(char c = ifs->get(); c!=endChar && !ifs->eof(); c = ifs->get())
+    // the text up to the closing quote is read at once, then the escape sequences are decoded
+    std::string& raw = rawBuf;
+    for(bool closed = false; !closed; )
     {
-        if(escape && c=='\\')
+        std::getline(*ifs, raw, endChar);
+        if(Dialect::strictSyntax && ifs->eof())
+            throw std::invalid_argument("Reader::readString : unterminated string");
+        closed = true;
+        if(escape && !ifs->eof())
         {
-            std::string hex; // nombres
-            int nbChar = 0;
-
-            c = ifs->get();
-            switch(c)
+            size_t last = raw.find_last_not_of('\\');
+            size_t slashes = raw.size() - (last == std::string::npos ? 0 : last + 1);
+            if(slashes % 2 == 1) // escaped quote, the string goes on
             {
-            // C escape sequences
-                case '0':   c = '\0'; break;
-                case 'a':   c = '\a'; break;
-                case 'b':   c = '\b'; break;
-                case 'f':   c = '\f'; break;
-                case 'n':   c = '\n'; break;
-                case 'r':   c = '\r'; break;
-                case 't':   c = '\t'; break;
-                case 'v':   c = '\v'; break;
-                case 'U':   nbChar = 8; // \Unnnnnnnn (UTF-32)
-                case 'u':   nbChar = 4; // \unnnn     (UTF-16)
-            // YAML escape sequences
-                case 'x':   nbChar = 2; // \xnn       (UTF-8)
-                    for(int i=0; i<nbChar; i++)
-                    {
-                        c = ifs->get();
-                        if(!ifs->eof() && isxdigit(c))
-                            hex.push_back(c);
-                        else
-                        {
-                            result.append(hex);
-                            break;
-                        }
-                    }
-                    goto l_convert;
-				case 'N':   hex = "0085"; goto l_convert;
-				case '_':   hex = "00a0"; goto l_convert;
-				case 'L':   hex = "2028"; goto l_convert;
-				case 'P':   hex = "2029"; goto l_convert;
-                l_convert:
-                    hex = utf8Convert(static_cast<unsigned int>(strtoul(hex.c_str(),0,16)));
-                    break;
-                case 'e':   c = 0x1b; break;
-                default:
-                    // TODO octal
-                    break;
+                raw.push_back(endChar);
+                closed = false;
             }
         }
-        if(!ifs->eof())
-            result.push_back(c);
+        if(escape && Dialect::strictSyntax && !Escape::isJson(raw))
+            throw std::invalid_argument("Reader::readString : invalid JSON escape sequence");
+        if(escape)
+            Escape::decode(raw, result);
+        else
+            result.append(raw);
     }
-    return result;
 }
 
 void sconvert(Variant* var, std::string& value, int base=10, bool isFloat=false)
@@ -344,20 +640,29 @@ void sconvert(Variant* var, std::string& value, int base=10, bool isFloat=false)
     }
 }
 
-void Reader::readNumber(Variant* num, std::string& str) const
+template<class Dialect>
+void BasicReader<Dialect>::readNumber(Variant* num, std::string& str) const
 {
-    if(str.size()>3 && str[0]=='0' && str[1]=='x') // hexadecimal
+    if(Dialect::extendedNumbers && str.size()>3 && str[0]=='0' && str[1]=='x') // hexadecimal
     {
         str.erase(0,2);
         sconvert(num,str,16);
     }
-    else if(str.size()>3 && str[0]=='0' && str[1]=='b') // binary
+    else if(Dialect::extendedNumbers && str.size()>3 && str[0]=='0' && str[1]=='b') // binary
     {
         str.erase(0,2);
         sconvert(num,str,2);
     }
     else // else a decimal number
     {
+        if(Dialect::strictSyntax)
+        {
+            bool isInteger = false;
+            if(!Escape::isJsonNumber(str, isInteger))
+                throw std::invalid_argument("Reader::readNumber : invalid JSON number");
+            sconvert(num,str,10,!isInteger);
+            return;
+        }
         unsigned int i = 0;
         bool isFloat = false;
         if(str[0]=='.')
@@ -381,3 +686,8 @@ void Reader::readNumber(Variant* num, std::string& str) const
     }
 }
 
+
+template class BasicReader<StrictJsonDialect>;
+template class BasicReader<Json5Dialect>;
+template class BasicReader<RelaxedDialect>;
+template class BasicReader<HoconDialect>;
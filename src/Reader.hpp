@@ -2,15 +2,122 @@
 #define READER_H
 
 #include "Variant.hpp"
+#include "Encoding.hpp"
 #include <istream>
+#include <memory>
 #include <string>
+#include <vector>
+
+class VariantPool;
+
+/*! \brief Dialect policy for strict JSON (RFC 8259).
+ *
+ * A dialect policy describes at compile time the syntax accepted by a BasicReader.
+ * Only the checks needed by the dialect are compiled in the reader.
+ *
+ * The other dialects count the syntax errors and go on. A strict dialect throws an std::invalid_argument on the
+ * first one: a trailing or doubled comma, a missing colon, a number out of the JSON grammar (see Escape::isJsonNumber()),
+ * an unquoted string, two tokens separated by blanks, an escape sequence which is not JSON (see Escape::isJson()),
+ * a string, array or object not closed at the end of the input, or anything but blanks after the root value.
+ */
+struct StrictJsonDialect
+{
+    static const bool equalKeyDelimiter = false;    //!< '=' can be used insteed of ':' after a key
+    static const bool semicolonDelimiter = false;   //!< ';' can be used insteed of ',' after a value
+    static const bool newlineDelimiter = false;     //!< A new line can be used insteed of ',' after a value
+    static const bool lineComments = false;         //!< C++ comments: <pre> // </pre>
+    static const bool blockComments = false;        //!< C comments: <pre> /\* *\/ </pre>
+    static const bool hashComments = false;         //!< Shell comments: <pre> # </pre>
+    static const bool customComment = false;        //!< Comments starting with the comment character of the reader
+    static const bool singleQuotes = false;         //!< Strings can be quoted with <pre> ' </pre>
+    static const bool unquotedKeys = false;         //!< Keys can be written without quotes
+    static const bool extendedNumbers = false;      //!< Hexadecimal and binary numbers are accepted
+    static const bool rootMap = false;              //!< parse() reads the keys of a map without braces
+    static const bool strictSyntax = true;          //!< The syntax errors are thrown insteed of counted
+};
+
+/*! \brief Dialect policy for JSON5: comments, single quotes, unquoted keys and hexadecimal numbers.
+ * \see StrictJsonDialect
+ */
+struct Json5Dialect
+{
+    static const bool equalKeyDelimiter = false;
+    static const bool semicolonDelimiter = false;
+    static const bool newlineDelimiter = false;
+    static const bool lineComments = true;
+    static const bool blockComments = true;
+    static const bool hashComments = false;
+    static const bool customComment = false;
+    static const bool singleQuotes = true;
+    static const bool unquotedKeys = true;
+    static const bool extendedNumbers = true;
+    static const bool rootMap = false;
+    static const bool strictSyntax = false;
+};
+
+/*! \brief Dialect policy for the relaxed INI like syntax: everything is accepted.
+ * \see StrictJsonDialect
+ */
+struct RelaxedDialect
+{
+    static const bool equalKeyDelimiter = true;
+    static const bool semicolonDelimiter = true;
+    static const bool newlineDelimiter = false;
+    static const bool lineComments = true;
+    static const bool blockComments = true;
+    static const bool hashComments = false;
+    static const bool customComment = true;
+    static const bool singleQuotes = true;
+    static const bool unquotedKeys = true;
+    static const bool extendedNumbers = true;
+    static const bool rootMap = true;
+    static const bool strictSyntax = false;
+};
+
+/*! \brief Dialect policy for a HOCON like syntax: keys delimited by '=' and values by new lines.
+ * \see StrictJsonDialect
+ */
+struct HoconDialect
+{
+    static const bool equalKeyDelimiter = true;
+    static const bool semicolonDelimiter = false;
+    static const bool newlineDelimiter = true;
+    static const bool lineComments = true;
+    static const bool blockComments = false;
+    static const bool hashComments = true;
+    static const bool customComment = false;
+    static const bool singleQuotes = false;
+    static const bool unquotedKeys = true;
+    static const bool extendedNumbers = false;
+    static const bool rootMap = true;
+    static const bool strictSyntax = false;
+};
+
 
 /*! \brief Class providing an interface to read a JSON input.
  *
  * Parsing methods construct a Variant object containing the data of the stream in a similar structure.
- * \see Variant, Writer
+ *
+ * The accepted syntax is given by the _Dialect_ policy (see StrictJsonDialect). The usual dialects have their own
+ * typedef: Reader (relaxed syntax), JsonReader, Json5Reader and HoconReader.
+ *
+ * A Reader can also be used on a stream of newline-delimited (JSON Lines) or concatenated documents.
+ * In this case each call to next() extracts a single document, and the internal buffers are kept
+ * from one document to the next:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * Reader reader(&stream);
+ * Variant doc;
+ * while(reader.next(doc))
+ *     process(doc);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The pull interface (beginDocument(), enterMap(), nextKey()...) reads the stream without building a Variant.
+ * It is used by ObjectReader to fill C++ structures directly.
+ * \see Variant, Writer, ObjectReader
  */
-class Reader
+template<class Dialect>
+class BasicReader
 {
     public:
         //**********************************************************************************************//
@@ -45,7 +152,7 @@ class Reader
          * \param input The input stream to read.
          * \throw std::logic_error is thrown if the stream is not good.
          */
-        Reader(std::istream* input);
+        BasicReader(std::istream* input);
 
         /*! \brief Modify the internal input stream.
          *
@@ -56,14 +163,116 @@ class Reader
          */
         void setStream(std::istream* input);
 
+        /*! \brief Validate the UTF-8 input while reading it.
+         *
+         * The stream is then read through a TranscodingBuffer, which checks each block just before it is parsed:
+         * an invalid document is rejected without a separate pass. The blocks are read ahead, so the stream is
+         * left after the position of the last document read.
+         * \param validate true to reject the invalid characters, false to accept them.
+         * \throw std::invalid_argument is then thrown by the parsing methods if the input contains an invalid
+         * character.
+         */
+        void setValidation(bool validate);
+
+        /*! \brief Set the table interning the keys of the maps.
+         *
+         * By default, the reader interns the keys in its own table, kept for all the documents it reads.
+         * A table can be shared by many readers so their documents share the same keys.
+         * \param table The table to use, or a null pointer to store a copy of each key.
+         * \see KeyTable
+         */
+        void setKeyTable(KeyTable* table);
+
+        /*! \brief Set the pool giving the storage of the values read.
+         *
+         * The strings, arrays, maps, packed arrays and shaped maps of the documents read are then taken from the
+         * pool, and the previous content of the results is released to it. BasicDocument uses a pool to parse many
+         * documents without allocations.
+         * \param valuePool The pool to use, or a null pointer to allocate the values.
+         * \see VariantPool
+         */
+        void setPool(VariantPool* valuePool);
+
         /*! \brief Read the internal input stream and extract data.
          *
          * All the elements of the stream are placed in a Variant objet.
          * \param result A Variant object containing all the data.
          * \throw std::logic_error is thrown if the stream is not good.
+         * \throw std::invalid_argument is thrown by a strict dialect if the input is not valid.
          */
         void parse(Variant &result);
 
+        /*! \brief Read the next document of the internal input stream.
+         *
+         * The documents of the stream can be separated by new lines (JSON Lines) or just concatenated.
+         * Each document is a map, an array or a single value, and is not forced into a top-level map.
+         * Separators <pre> , ; </pre> between documents are ignored.
+         * \param result A Variant object receiving the data of the document.
+         * \return false if the end of the stream is reached before any new document, true otherwise.
+         * \throw std::logic_error is thrown if the stream is not good.
+         */
+        bool next(Variant &result);
+
+
+        //**********************************************************************************************//
+        //**************************************  Pull interface  **************************************//
+        //**********************************************************************************************//
+        /*! \brief Start reading the next document of the stream with the pull interface.
+         *
+         * The pull interface reads the stream step by step without building a Variant. The current position is
+         * always a value position (the start of a document, after a key or in an array), where one of the methods
+         * enterMap(), enterArray(), readText(), readVariant() or skipValue() must be called.
+         * This interface is used by ObjectReader to fill C++ objects directly.
+         * \return false if the end of the stream is reached before any new document, true otherwise.
+         * \throw std::logic_error is thrown if the stream is not good.
+         */
+        bool beginDocument();
+
+        /*! \brief Enter the map at the current value position.
+         *
+         * The keys are then read with nextKey().
+         * \return false if the value is not a map. In this case, nothing is read.
+         */
+        bool enterMap();
+
+        /*! \brief Enter the array at the current value position.
+         *
+         * The items are then read with nextItem().
+         * \return false if the value is not an array. In this case, nothing is read.
+         */
+        bool enterArray();
+
+        /*! \brief Read the next key of the current map.
+         *
+         * The position is then on the value of the key.
+         * \param key The string receiving the key.
+         * \return false if the end of the map is reached.
+         */
+        bool nextKey(std::string& key);
+
+        /*! \brief Go to the next item of the current array.
+         *
+         * \return false if the end of the array is reached.
+         */
+        bool nextItem();
+
+        /*! \brief Read the text of a scalar value at the current value position.
+         *
+         * If the value is a map or an array, it is skipped.
+         * \param text The string receiving the text of the value.
+         * \param isString Set to true if the value was a string literal.
+         * \return false if the value was not a scalar.
+         */
+        bool readText(std::string& text, bool& isString);
+
+        /*! \brief Read the value at the current value position in a Variant object.
+         */
+        void readVariant(Variant& value);
+
+        /*! \brief Skip the value at the current value position.
+         */
+        void skipValue();
+
 
 
 
@@ -72,7 +281,29 @@ class Reader
         int nbErrors;       //!< Number of syntax errors found. Not used yet.
         char charBuf;       //!< A buffer containing the character read.
         char comment;       //!< The comment caracter.
+        bool started;       //!< The first character of the stream has been read by next().
+        bool ended;         //!< The last value read was followed by the end of its container.
+        bool delimited;     //!< A value delimiter was read after the last value.
+        size_t arrayDepth;  //!< Number of arrays containing the current value.
+        KeyTable ownKeys;   //!< The default table of keys.
+        KeyTable* keys;     //!< The table interning the keys, or null.
+        std::vector<size_t> sizeHints;  //!< Size of the last array read at each depth, reserved for the next one.
+        VariantPool* pool;  //!< The pool of the values, or null.
+        std::string keyBuf; //!< Buffer for the keys, reused between documents.
+        std::string strBuf; //!< Buffer for the values, reused between documents.
+        std::string rawBuf; //!< Buffer for the quoted strings before decoding their escape sequences.
+        bool validation;    //!< The input is validated.
+        std::unique_ptr<TranscodingBuffer> validator;   //!< The buffer validating the input stream.
+        std::istream validated;                         //!< The stream read through _validator_.
+
 
+        /*! Set _ifs_ to _input_, or to the stream validating it.
+         */
+        void bindStream(std::istream* input);
+
+        /*! Count a syntax error found by _function_, or throw it if the dialect is strict.
+         */
+        void syntaxError(const char* function);
 
         /*! Read the next character from the stream.
          *  It is placed in the buffer charBuf and returned.
@@ -89,30 +320,67 @@ class Reader
          */
         void readKey(std::string& key);
 
+        /*! Skip the blanks before a value.
+         */
+        void skipBlanks();
+
+        /*! Read the end of a value: the following delimiter, or the end of the container.
+         *  Sets _ended_ if the container is ended.
+         */
+        void endValue();
+
         /*! Read the next expression from the stream (a map, an array, or another value).
          *  Ends the read after one of theses symbols: <pre> , ; ] } </pre>.
+         *  Returns false if the container of the value is ended.
          */
         bool readValue(Variant* exp);
 
         /*! Read the differents values of a map from the stream.
-         *  Ends the read after one of theses symbols: <pre> ] } </pre>.
+         *  Ends the read after the value delimiter following the map.
          */
         void readMap(Variant* vmap);
 
+        /*! Insert _key_ in the map _vmap_, interned if there is a table of keys.
+         */
+        Variant& insertKey(Variant* vmap, const std::string& key);
+
         /*! Read the differents values of an array from the stream.
-         *  Ends the read after one of theses symbols: <pre> ] } </pre>.
+         *  Ends the read after the value delimiter following the array.
          */
         void readArray(Variant* varray);
 
-        /*! Read a string literal from the stream.
+        /*! Check if the character is a blank between two tokens.
+         *  New lines are blanks only if they are not value delimiters.
+         */
+        bool isBlank(char c) const;
+
+        /*! Check if the character ends a key.
+         */
+        bool isKeyDelimiter(char c) const;
+
+        /*! Check if the character ends a value.
+         */
+        bool isValueDelimiter(char c) const;
+
+        /*! Convert the text _str_ of a value in the best type and place it in _exp_.
+         *  If isString is set to true, the text was a string literal and is kept as is.
+         */
+        void readScalar(Variant* exp, std::string& str, bool isString) const;
+
+        /*! Read a string literal from the stream and append it to _result_.
          *  Ends the read after one the character _endChar_.
-         *  If escape is set to true, escape sequence are converted to their spacial meaning.
+         *  If escape is set to true, escape sequence are converted to their spacial meaning (see Escape).
          */
-        std::string readString(char endChar, bool escape) const;
+        void readString(std::string& result, char endChar, bool escape);
 
         /*! Convert the string _str_ in a numerical value placed in _num_ with the best type.
          */
         void readNumber(Variant* num, std::string& str) const;
 };
 
+typedef BasicReader<RelaxedDialect> Reader;         //!< Reader of the relaxed syntax.
+typedef BasicReader<StrictJsonDialect> JsonReader;  //!< Reader of strict JSON.
+typedef BasicReader<Json5Dialect> Json5Reader;      //!< Reader of JSON5.
+typedef BasicReader<HoconDialect> HoconReader;      //!< Reader of a HOCON like syntax.
+
 #endif // READER_H
@@ -0,0 +1,210 @@
+#include "Shape.hpp"
+#include <algorithm>
+
+namespace
+{
+    /*! Check if the maps _a_ and _b_ have the same keys, without converting them.
+     */
+    bool sameKeys(const Variant& a, const Variant& b)
+    {
+        if(a.isShaped())
+            return b.isShaped() ? a.getShape() == b.getShape() : a.getShape()->sameKeys(b.getMap());
+        if(b.isShaped())
+            return b.getShape()->sameKeys(a.getMap());
+        const Variant::MapType& x = a.getMap();
+        const Variant::MapType& y = b.getMap();
+        return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin(),
+            [](const Variant::MapType::value_type& l, const Variant::MapType::value_type& r) { return l.first == r.first; });
+    }
+}
+
+//****************************** Shape *******************************//
+Shape::Shape(const Variant::MapType& map)
+{
+    keys.reserve(map.size());
+    for(Variant::MapType::const_iterator it = map.begin(); it != map.end(); ++it)
+        keys.push_back(it->first);
+}
+
+size_t Shape::size() const {
+    return keys.size(); }
+
+const Key& Shape::key(size_t slot) const {
+    return keys[slot]; }
+
+int Shape::find(std::string_view key) const
+{
+    std::vector<Key>::const_iterator it = std::lower_bound(keys.begin(), keys.end(), key, std::less<>());
+    if(it == keys.end() || !(*it == key))
+        return -1;
+    return static_cast<int>(it - keys.begin());
+}
+
+bool Shape::sameKeys(const Variant::MapType& map) const
+{
+    if(map.size() != keys.size())
+        return false;
+    std::vector<Key>::const_iterator k = keys.begin();
+    for(Variant::MapType::const_iterator it = map.begin(); it != map.end(); ++it, ++k)
+        if(!(it->first == *k))
+            return false;
+    return true;
+}
+
+
+//****************************** PackedArray *******************************//
+Variant Variant::PackedArray::number(size_t index) const
+{
+    switch(elementType)
+    {
+        case Variant::INT:      return Variant(ints[index]);
+        case Variant::LONG:     return Variant(longs[index]);
+        case Variant::FLOAT:    return Variant(floats[index]);
+        default:                return Variant(doubles[index]);
+    }
+}
+
+const Variant& Variant::PackedArray::element(size_t index) const
+{
+    std::atomic<Variant*>* table = blocks.load(std::memory_order_acquire);
+    if(!table)
+    {
+        std::atomic<Variant*>* built = new std::atomic<Variant*>[(size() + blockSize - 1) / blockSize]();
+        if(blocks.compare_exchange_strong(table, built, std::memory_order_acq_rel))
+            table = built;
+        else
+            delete[] built; // built meanwhile by another thread
+    }
+
+    std::atomic<Variant*>& slot = table[index / blockSize];
+    Variant* block = slot.load(std::memory_order_acquire);
+    if(!block)
+    {
+        size_t first = index - index % blockSize;
+        size_t count = std::min(blockSize, size() - first);
+        Variant* built = new Variant[count];
+        for(size_t i = 0; i < count; i++)
+            built[i] = number(first + i);
+        if(slot.compare_exchange_strong(block, built, std::memory_order_acq_rel))
+            block = built;
+        else
+            delete[] built;
+    }
+    return block[index % blockSize];
+}
+
+const Variant::ArrayType& Variant::PackedArray::getElements() const
+{
+    ArrayType* current = elements.load(std::memory_order_acquire);
+    if(current)
+        return *current;
+
+    ArrayType* built = new ArrayType();
+    built->reserve(size());
+    switch(elementType)
+    {
+        case Variant::INT:      built->assign(ints.begin(), ints.end()); break;
+        case Variant::LONG:     built->assign(longs.begin(), longs.end()); break;
+        case Variant::FLOAT:    built->assign(floats.begin(), floats.end()); break;
+        default:                built->assign(doubles.begin(), doubles.end()); break;
+    }
+    if(elements.compare_exchange_strong(current, built, std::memory_order_acq_rel))
+        return *built;
+    delete built; // built meanwhile by another thread
+    return *current;
+}
+
+void Variant::PackedArray::dropElements()
+{
+    delete elements.exchange(0);
+    std::atomic<Variant*>* table = blocks.exchange(0);
+    if(!table)
+        return;
+    // the size is the one of the table, as the numbers are not modified yet
+    for(size_t i = 0; i < (size() + blockSize - 1) / blockSize; i++)
+        delete[] table[i].load();
+    delete[] table;
+}
+
+
+//****************************** ShapedMap *******************************//
+const Variant::MapType& Variant::ShapedMap::getEntries() const
+{
+    MapType* current = entries.load(std::memory_order_acquire);
+    if(current)
+        return *current;
+
+    MapType* built = new MapType();
+    for(size_t i = 0; i < values.size(); i++)
+        built->emplace_hint(built->end(), shape->key(i), values[i]);
+    if(entries.compare_exchange_strong(current, built, std::memory_order_acq_rel))
+        return *built;
+    delete built; // built meanwhile by another thread
+    return *current;
+}
+
+
+//****************************** ArrayBuilder *******************************//
+void ArrayBuilder::append(Variant&& item)
+{
+    if(pool ? pool->insertPacked(array, item) : array.insertPacked(item))
+        return;
+
+    // only the maps with the keys of the current shape are shaped, the others stay regular maps
+    if(item.getType() == Variant::MAP && item.size() > 0)
+    {
+        if(shape)
+        {
+            if(item.isShaped() ? item.getShape() == shape : shape->sameKeys(item.getMap()))
+                shapeAs(item);
+        }
+        else if(firstMap >= 0 && sameKeys(array[firstMap], item))
+        {
+            shapeAs(array[firstMap]);
+            shapeAs(item);
+        }
+        else
+            firstMap = array.size(); // wait for a second map with the keys of this one
+    }
+    array.insert(std::move(item));
+}
+
+void ArrayBuilder::appendAll(Variant& items)
+{
+    if(items.getType() != Variant::SEQUENCE)
+        return;
+    switch(items.getPackedType())
+    {
+        case Variant::INT:
+            for(int num : items.getIntArray())
+                append(Variant(num));
+            break;
+        case Variant::LONG:
+            for(long long num : items.getLongArray())
+                append(Variant(num));
+            break;
+        case Variant::FLOAT:
+            for(float num : items.getFloatArray())
+                append(Variant(num));
+            break;
+        case Variant::DOUBLE:
+            for(double num : items.getDoubleArray())
+                append(Variant(num));
+            break;
+        default:
+            {
+                Variant::ArrayType& elements = items.getArray();
+                for(size_t i = 0; i < elements.size(); i++)
+                    append(std::move(elements[i]));
+            }
+            break;
+    }
+}
+
+void ArrayBuilder::shapeAs(Variant& map)
+{
+    if(pool)
+        pool->shapeAs(map, shape);
+    else
+        map.shapeAs(shape);
+}
@@ -0,0 +1,237 @@
+#ifndef SHAPE_H
+#define SHAPE_H
+
+#include "Variant.hpp"
+#include "VariantPool.hpp"
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string>
+
+/*! \brief Class describing the keys of shaped maps.
+ *
+ * A shaped map stores its values in a vector, in the order of the keys of its Shape. The maps of an array of
+ * records with the same keys share the same shape, so each record only stores its values.
+ * The keys are sorted, so the values are in the same order as the entries of a regular map.
+ * \see Variant::shapeAs(), FieldLookup
+ */
+class Shape
+{
+    public:
+        /*! \brief Construct the shape of the keys of _map_.
+         */
+        explicit Shape(const Variant::MapType& map);
+
+        /*! \brief Get the number of keys.
+         */
+        size_t size() const;
+
+        /*! \brief Get the key of a slot.
+         */
+        const Key& key(size_t slot) const;
+
+        /*! \brief Get the slot of a key.
+         * \return The slot of _key_, or a negative value if the key is not in the shape.
+         */
+        int find(std::string_view key) const;
+
+        /*! \brief Check if _map_ has exactly the keys of the shape.
+         */
+        bool sameKeys(const Variant::MapType& map) const;
+
+
+
+
+    private:
+        std::vector<Key> keys;  //!< The keys of the slots, sorted.
+};
+
+
+/*! Storage of a packed array: only the vector of elementType is used.
+ *
+ * The const accessors returning a reference need Variant elements: operator[] builds them by blocks of
+ * _blockSize_, only for the blocks accessed, and getArray() builds a copy of the whole array.
+ */
+struct Variant::PackedArray
+{
+    static constexpr size_t blockSize = 64;    //!< Number of elements built at once by element().
+
+    VariantType elementType;
+    std::vector<int> ints;
+    std::vector<long long> longs;
+    std::vector<float> floats;
+    std::vector<double> doubles;
+    mutable std::atomic<ArrayType*> elements;               //!< Read-only copy of the elements for getArray() const, or null.
+    mutable std::atomic<std::atomic<Variant*>*> blocks;     //!< Table of the read-only blocks of elements, or null.
+
+    PackedArray() : elements(0), blocks(0) {}
+
+    PackedArray(const PackedArray& array) :
+        elementType(array.elementType),
+        ints(array.ints),
+        longs(array.longs),
+        floats(array.floats),
+        doubles(array.doubles),
+        elements(0),
+        blocks(0)
+    {}
+
+    ~PackedArray()
+    {
+        dropElements();
+    }
+
+    /*! Get the number _index_ in a Variant.
+     */
+    Variant number(size_t index) const;
+
+    /*! Get a read-only element, built with the other elements of its block by the first caller.
+     *  Many threads can call it at once.
+     */
+    const Variant& element(size_t index) const;
+
+    /*! Get the read-only copy of all the elements, built by the first caller. Many threads can call it at once.
+     *  It is the slow path of getArray() const: the copy takes several times the memory of the numbers, and is
+     *  kept until the array is modified.
+     */
+    const ArrayType& getElements() const;
+
+    /*! Drop the copies of the elements, before a modification.
+     */
+    void dropElements();
+
+    /*! Remove the numbers, keeping the storage. Used by VariantPool.
+     */
+    void clear()
+    {
+        dropElements();
+        ints.clear();
+        longs.clear();
+        floats.clear();
+        doubles.clear();
+    }
+
+    size_t size() const
+    {
+        switch(elementType)
+        {
+            case Variant::INT:      return ints.size();
+            case Variant::LONG:     return longs.size();
+            case Variant::FLOAT:    return floats.size();
+            default:                return doubles.size();
+        }
+    }
+
+    void reserve(size_t size)
+    {
+        switch(elementType)
+        {
+            case Variant::INT:      ints.reserve(size); break;
+            case Variant::LONG:     longs.reserve(size); break;
+            case Variant::FLOAT:    floats.reserve(size); break;
+            default:                doubles.reserve(size); break;
+        }
+    }
+};
+
+
+/*! Storage of a shaped map: the values are in the order of the keys of the shape.
+ */
+struct Variant::ShapedMap
+{
+    std::shared_ptr<const Shape> shape;
+    std::vector<Variant> values;
+    mutable std::atomic<MapType*> entries;  //!< Read-only copy of the entries for getMap() const, or null.
+
+    ShapedMap() : entries(0) {}
+    ShapedMap(const ShapedMap& map) : shape(map.shape), values(map.values), entries(0) {}
+    ~ShapedMap() { delete entries.load(); }
+
+    /*! Get the read-only copy of the entries, built by the first caller. Many threads can call it at once.
+     */
+    const MapType& getEntries() const;
+
+    /*! Drop the copy of the entries, before a value is modified.
+     */
+    void dropEntries() { delete entries.exchange(0); }
+};
+
+
+/*! \brief Class caching the slot of a key in the shaped maps, for repeated accesses at the same place of the code.
+ *
+ * The slot found for the last shape is remembered, so the access to the same field of the records of an array
+ * doesn't search the key again:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * static thread_local FieldLookup name("name");
+ * for(size_t i = 0; i < records.size(); i++)
+ *     process(records[i][name].toString());
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * A regular map is accessed like with the key itself.
+ * \note A FieldLookup is modified by each access, so it must not be shared between threads.
+ * \see Shape, Variant
+ */
+class FieldLookup
+{
+    public:
+        /*! \brief Construct a lookup for the key _key_.
+         */
+        explicit FieldLookup(std::string_view key) : name(key), slot(0) {}
+
+        /*! \brief Get the key.
+         */
+        const std::string& key() const {
+            return name; }
+
+
+
+
+    private:
+        std::string name;                   //!< The key.
+        std::shared_ptr<const Shape> shape; //!< The last shape, kept alive so its address is not reused.
+        size_t slot;                        //!< The slot of the key in the last shape.
+
+        friend class Variant;
+};
+
+
+/*! \brief Class used by the readers to fill an array.
+ *
+ * The numbers are packed while they have the same type (see Variant::insertPacked()), and the maps share their
+ * shape when they have the same keys. A map is shaped only when a second map has its keys, so a single map stays
+ * a regular map. Once a shape is found, the maps with other keys stay regular maps. With a VariantPool, the packed
+ * arrays, the shaped maps and the shapes are taken from it.
+ */
+class ArrayBuilder
+{
+    public:
+        /*! \brief Construct a builder appending the elements of _array_, with the storage of _pool_ if not null.
+         */
+        explicit ArrayBuilder(Variant& array, VariantPool* pool = 0) : array(array), pool(pool), firstMap(-1) {}
+
+        /*! \brief Append _item_ at the end of the array, moving its content.
+         */
+        void append(Variant&& item);
+
+        /*! \brief Append the elements of the array _items_, moving their content.
+         *
+         * Used to join the parts of an array read separately. Nothing is done if _items_ is not an array.
+         */
+        void appendAll(Variant& items);
+
+
+
+
+    private:
+        Variant& array;                     //!< The array to fill.
+        VariantPool* pool;                  //!< The pool giving the storage, or null.
+        std::shared_ptr<const Shape> shape; //!< The shape of the last maps.
+        long firstMap;                      //!< The index of the last map, waiting for a second one with its keys.
+
+        /*! Shape _map_ with the shape of the last maps.
+         */
+        void shapeAs(Variant& map);
+};
+
+#endif // SHAPE_H
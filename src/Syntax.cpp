@@ -0,0 +1,407 @@
+#include "Syntax.hpp"
+#include "YamlReader.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <bitset>
+#include <map>
+
+namespace
+{
+    typedef std::bitset<256> CharSet;
+
+    struct NfaState
+    {
+        CharSet chars;          // characters of the transition
+        int next;               // target of the transition, -1 if none
+        std::vector<int> eps;   // epsilon transitions
+        int token;              // token recognized, -1 if none
+    };
+
+    struct Fragment
+    {
+        int start;
+        int end;                // no transition yet
+    };
+
+    struct TokenDef
+    {
+        bool regex;
+        std::string name;
+        std::string pattern;
+
+        bool operator<(const TokenDef& t) const {
+            return regex != t.regex ? !regex : name < t.name; }
+    };
+
+    // Thompson construction of a non deterministic automaton
+    class Nfa
+    {
+        public:
+            std::vector<NfaState> states;
+
+            int newState()
+            {
+                NfaState s;
+                s.next = -1;
+                s.token = -1;
+                states.push_back(s);
+                return states.size() - 1;
+            }
+
+            Fragment empty()
+            {
+                int s = newState();
+                Fragment f = { s, s };
+                return f;
+            }
+
+            Fragment chars(const CharSet& set)
+            {
+                Fragment f = { newState(), newState() };
+                states[f.start].chars = set;
+                states[f.start].next = f.end;
+                return f;
+            }
+
+            Fragment concat(Fragment a, Fragment b)
+            {
+                states[a.end].eps.push_back(b.start);
+                Fragment f = { a.start, b.end };
+                return f;
+            }
+
+            Fragment alternative(Fragment a, Fragment b)
+            {
+                Fragment f = { newState(), newState() };
+                states[f.start].eps.push_back(a.start);
+                states[f.start].eps.push_back(b.start);
+                states[a.end].eps.push_back(f.end);
+                states[b.end].eps.push_back(f.end);
+                return f;
+            }
+
+            Fragment repeat(Fragment a, char op)
+            {
+                Fragment f = { a.start, newState() };
+                if(op != '+')
+                {
+                    f.start = newState();
+                    states[f.start].eps.push_back(a.start);
+                    states[f.start].eps.push_back(f.end);
+                }
+                if(op != '?')
+                    states[a.end].eps.push_back(a.start);
+                states[a.end].eps.push_back(f.end);
+                return f;
+            }
+
+            Fragment literal(const std::string& str)
+            {
+                Fragment f = empty();
+                for(size_t i = 0; i < str.size(); i++)
+                {
+                    CharSet set;
+                    set.set(static_cast<unsigned char>(str[i]));
+                    f = concat(f, chars(set));
+                }
+                return f;
+            }
+
+            Fragment regex(const std::string& str, const std::string& name)
+            {
+                re = &str;
+                reName = &name;
+                pos = 0;
+                Fragment f = parseAlternative();
+                if(pos != str.size())
+                    error();
+                return f;
+            }
+
+        private:
+            const std::string* re;
+            const std::string* reName;
+            size_t pos;
+
+            [[noreturn]] void error()
+            {
+                throw std::invalid_argument("Syntax::Syntax : invalid regular expression for " + *reName);
+            }
+
+            bool more() const {
+                return pos < re->size(); }
+
+            unsigned char escape(char c) const
+            {
+                switch(c)
+                {
+                    case '0': return '\0';
+                    case 't': return '\t';
+                    case 'n': return '\n';
+                    case 'r': return '\r';
+                    default:  return c;
+                }
+            }
+
+            Fragment parseAlternative()
+            {
+                Fragment f = parseConcat();
+                while(more() && (*re)[pos] == '|')
+                {
+                    pos++;
+                    f = alternative(f, parseConcat());
+                }
+                return f;
+            }
+
+            Fragment parseConcat()
+            {
+                Fragment f = empty();
+                while(more() && (*re)[pos] != '|' && (*re)[pos] != ')')
+                    f = concat(f, parseRepeat());
+                return f;
+            }
+
+            Fragment parseRepeat()
+            {
+                Fragment f = parseAtom();
+                while(more() && ((*re)[pos] == '*' || (*re)[pos] == '+' || (*re)[pos] == '?'))
+                    f = repeat(f, (*re)[pos++]);
+                return f;
+            }
+
+            Fragment parseAtom()
+            {
+                CharSet set;
+                char c = (*re)[pos++];
+                switch(c)
+                {
+                    case '(':
+                        {
+                            Fragment f = parseAlternative();
+                            if(!more() || (*re)[pos] != ')')
+                                error();
+                            pos++;
+                            return f;
+                        }
+                    case '[':
+                        return chars(parseClass());
+                    case '.':
+                        set.set();
+                        set.reset('\n');
+                        return chars(set);
+                    case '\\':
+                        if(!more())
+                            error();
+                        set.set(escape((*re)[pos++]));
+                        return chars(set);
+                    case ')':
+                    case '*':
+                    case '+':
+                    case '?':
+                        error();
+                    default:
+                        set.set(static_cast<unsigned char>(c));
+                        return chars(set);
+                }
+            }
+
+            // on entre apres : [
+            // on sort apres : ]
+            CharSet parseClass()
+            {
+                CharSet set;
+                bool negate = more() && (*re)[pos] == '^';
+                if(negate)
+                    pos++;
+                bool first = true;
+                while(more() && ((*re)[pos] != ']' || first))
+                {
+                    first = false;
+                    unsigned char lo = (*re)[pos++];
+                    if(lo == '\\' && more())
+                        lo = escape((*re)[pos++]);
+                    unsigned char hi = lo;
+                    if(pos + 1 < re->size() && (*re)[pos] == '-' && (*re)[pos+1] != ']')
+                    {
+                        pos++;
+                        hi = (*re)[pos++];
+                        if(hi == '\\' && more())
+                            hi = escape((*re)[pos++]);
+                        if(hi < lo)
+                            error();
+                    }
+                    for(unsigned int i = lo; i <= hi; i++)
+                        set.set(i);
+                }
+                if(!more())
+                    error();
+                pos++;
+                return negate ? ~set : set;
+            }
+    };
+
+    bool isLiteral(const std::string& pattern)
+    {
+        return pattern.find_first_of("\\.[]()|*+?") == std::string::npos;
+    }
+
+    void closure(const Nfa& nfa, std::vector<int>& set)
+    {
+        std::vector<bool> in(nfa.states.size(), false);
+        std::vector<int> stack(set);
+        for(size_t i = 0; i < set.size(); i++)
+            in[set[i]] = true;
+        while(!stack.empty())
+        {
+            int s = stack.back();
+            stack.pop_back();
+            const std::vector<int>& eps = nfa.states[s].eps;
+            for(size_t i = 0; i < eps.size(); i++)
+            {
+                if(!in[eps[i]])
+                {
+                    in[eps[i]] = true;
+                    set.push_back(eps[i]);
+                    stack.push_back(eps[i]);
+                }
+            }
+        }
+        std::sort(set.begin(), set.end());
+    }
+}
+
+
+Syntax Syntax::loadFile(std::string file)
+{
+    Variant definition;
+    YamlReader::parseFile(definition, file);
+    return Syntax(definition);
+}
+
+
+//******************************** Constructors *******************************//
+Syntax::Syntax(const Variant& definition)
+{
+    if(definition.getType() != Variant::MAP)
+        throw std::invalid_argument("Syntax::Syntax : the definition is not a map");
+
+    // list of tokens, by priority
+    std::vector<TokenDef> defs;
+    const char* sections[] = { "tokens", "scalar tokens", "type tokens" };
+    for(int i = 0; i < 3; i++)
+    {
+        Variant::MapType::const_iterator sec = definition.getMap().find(sections[i]);
+        if(sec == definition.getMap().end() || sec->second.getType() != Variant::MAP)
+            continue;
+        const Variant::MapType& tokens = sec->second.getMap();
+        for(Variant::MapType::const_iterator it = tokens.begin(); it != tokens.end(); ++it)
+        {
+            if(it->second.getType() != Variant::STRING)
+                throw std::invalid_argument("Syntax::Syntax : the value of " + it->first.str() + " is not a string");
+            TokenDef def;
+            def.name = it->first.str();
+            def.pattern = it->second.toString();
+            def.regex = (i > 0 || def.name == "--ignore--") && !isLiteral(def.pattern);
+            defs.push_back(def);
+        }
+    }
+    std::sort(defs.begin(), defs.end());
+
+    // non deterministic automaton
+    Nfa nfa;
+    int start = nfa.newState();
+    for(size_t i = 0; i < defs.size(); i++)
+    {
+        Fragment f = defs[i].regex ? nfa.regex(defs[i].pattern, defs[i].name) : nfa.literal(defs[i].pattern);
+        nfa.states[start].eps.push_back(f.start);
+        nfa.states[f.end].token = i;
+        names.push_back(defs[i].name);
+        ignored.push_back(defs[i].name == "--ignore--");
+    }
+
+    // classes of characters having the same transitions
+    std::vector<const CharSet*> sets;
+    for(size_t i = 0; i < nfa.states.size(); i++)
+        if(nfa.states[i].next >= 0)
+            sets.push_back(&nfa.states[i].chars);
+    std::map<std::vector<bool>,int> signatures;
+    std::vector<int> representative;
+    for(int c = 0; c < 256; c++)
+    {
+        std::vector<bool> sign(sets.size());
+        for(size_t i = 0; i < sets.size(); i++)
+            sign[i] = sets[i]->test(c);
+        std::map<std::vector<bool>,int>::iterator it = signatures.find(sign);
+        if(it == signatures.end())
+        {
+            it = signatures.insert(std::make_pair(sign, static_cast<int>(representative.size()))).first;
+            representative.push_back(c);
+        }
+        classes[c] = it->second;
+    }
+    nbClasses = representative.size();
+
+    // deterministic automaton by subset construction
+    std::map<std::vector<int>,int> dstates;
+    std::vector<std::vector<int> > todo;
+    todo.push_back(std::vector<int>(1, start));
+    closure(nfa, todo[0]);
+    dstates[todo[0]] = 0;
+    for(size_t d = 0; d < todo.size(); d++)
+    {
+        const std::vector<int> current(todo[d]);
+        int token = ERROR;
+        for(size_t i = 0; i < current.size(); i++)
+        {
+            int t = nfa.states[current[i]].token;
+            if(t >= 0 && (token == ERROR || t < token))
+                token = t;
+        }
+        accepts.push_back(token);
+
+        for(int k = 0; k < nbClasses; k++)
+        {
+            std::vector<int> target;
+            for(size_t i = 0; i < current.size(); i++)
+            {
+                const NfaState& s = nfa.states[current[i]];
+                if(s.next >= 0 && s.chars.test(representative[k]))
+                    target.push_back(s.next);
+            }
+            int id = -1;
+            if(!target.empty())
+            {
+                closure(nfa, target);
+                std::map<std::vector<int>,int>::iterator it = dstates.find(target);
+                if(it == dstates.end())
+                {
+                    it = dstates.insert(std::make_pair(target, static_cast<int>(todo.size()))).first;
+                    todo.push_back(target);
+                }
+                id = it->second;
+            }
+            transitions.push_back(id);
+        }
+    }
+}
+
+
+//****************************** Public functions *******************************//
+size_t Syntax::tokenCount() const {
+    return names.size(); }
+
+const std::string& Syntax::tokenName(int token) const {
+    return names.at(token); }
+
+int Syntax::tokenId(const std::string& name) const
+{
+    std::vector<std::string>::const_iterator it = std::find(names.begin(), names.end(), name);
+    return it == names.end() ? ERROR : static_cast<int>(it - names.begin());
+}
+
+bool Syntax::isIgnored(int token) const {
+    return token >= 0 && ignored[token]; }
+
+size_t Syntax::stateCount() const {
+    return accepts.size(); }
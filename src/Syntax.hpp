@@ -0,0 +1,114 @@
+#ifndef SYNTAX_H
+#define SYNTAX_H
+
+#include "Variant.hpp"
+#include <string>
+#include <vector>
+
+/*! \brief Class containing the lexical tables of a language, compiled from a syntax definition.
+ *
+ * A syntax definition is a YAML document like the ones in the _syntax_ directory. The following sections are used:
+ *  - <em>tokens</em>: the fixed tokens of the language, their value is a literal string.
+ *    The special token <em>\-\-ignore\-\-</em> is a regular expression matching the text to skip.
+ *  - <em>scalar tokens</em> (or <em>type tokens</em>): the tokens of the scalar values, their value is a regular expression.
+ *
+ * The other sections (grammar...) are not used by the lexer.
+ *
+ * All the tokens are compiled in a single deterministic automaton. The bytes having the same transitions are grouped in
+ * classes, so the transition table contains one row per state and one column per class. These tables are used by the
+ * generic lexer engine TableLexer.
+ *
+ * The regular expressions support: literal characters, escape sequences <pre> \\t \\n \\r \\\\ \\. ... </pre>, any character
+ * <pre> . </pre>, classes <pre> [a-z] [^"] </pre>, groups <pre> ( ) </pre>, alternatives <pre> | </pre> and
+ * repetitions <pre> * + ? </pre>.
+ *
+ * When many tokens match the longest text, a literal token wins over a regular expression, then the first
+ * token in alphabetical order.
+ *
+ * \note Indentation based languages like YAML can't be described with these tables and keep their own Lexer.
+ * \see TableLexer
+ */
+class Syntax
+{
+    public:
+        /*! \brief Special token numbers returned by the lexer engine.
+         */
+        enum SpecialToken {
+            END = -1,       //!< The end of the stream is reached
+            ERROR = -2      //!< The text doesn't match any token
+        };
+
+        //**********************************************************************************************//
+        //**************************************  Static members  **************************************//
+        //**********************************************************************************************//
+        /*! \brief Read a syntax definition file and compile it.
+         *
+         * \param file The YAML file containing the syntax definition.
+         * \return The compiled syntax.
+         * \throw std::invalid_argument is thrown if the file cannot be opened or if a regular expression is invalid.
+         */
+        static Syntax loadFile(std::string file);
+
+
+        //**********************************************************************************************//
+        //**************************************  Public methods  **************************************//
+        //**********************************************************************************************//
+        /*! \brief Compile a syntax definition.
+         *
+         * \param definition The syntax definition, as read from a YAML file.
+         * \throw std::invalid_argument is thrown if a regular expression is invalid.
+         */
+        Syntax(const Variant& definition);
+
+        /*! \brief Get the number of tokens of the language.
+         */
+        size_t tokenCount() const;
+
+        /*! \brief Get the name of a token.
+         */
+        const std::string& tokenName(int token) const;
+
+        /*! \brief Get the number of a token from its name.
+         * \return The number of the token, or Syntax::ERROR if the token doesn't exist.
+         */
+        int tokenId(const std::string& name) const;
+
+        /*! \brief Check if the text of a token must be skipped by the lexer.
+         */
+        bool isIgnored(int token) const;
+
+        /*! \brief Get the number of states of the automaton.
+         */
+        size_t stateCount() const;
+
+        /*! \brief Get the next state of the automaton.
+         *
+         * The first state is 0.
+         * \return The next state, or a negative value if the character can't be read from _state_.
+         */
+        inline int transition(int state, unsigned char c) const
+        {
+            return transitions[state * nbClasses + classes[c]];
+        }
+
+        /*! \brief Get the token recognized in a state.
+         * \return The number of the token, or Syntax::ERROR if the state doesn't end any token.
+         */
+        inline int accepted(int state) const
+        {
+            return accepts[state];
+        }
+
+
+
+
+    private:
+        std::vector<std::string> names;     //!< The names of the tokens.
+        std::vector<bool> ignored;          //!< The tokens to skip.
+        unsigned char classes[256];         //!< The class of each byte.
+        int nbClasses;                      //!< The number of classes.
+        std::vector<int> transitions;       //!< The transition table, one row of nbClasses columns for each state.
+        std::vector<int> accepts;           //!< The token recognized in each state.
+};
+
+#endif // SYNTAX_H
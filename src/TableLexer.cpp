@@ -0,0 +1,64 @@
+#include "TableLexer.hpp"
+
+//******************************** Constructors *******************************//
+TableLexer::TableLexer(const Syntax& syntax, std::istream& input) :
+    syntax(syntax),
+    buf(input.rdbuf()),
+    pendingPos(0)
+{}
+
+
+//****************************** Public functions *******************************//
+int TableLexer::next()
+{
+    while(true)
+    {
+        value.clear();
+        int state = 0;
+        int token = Syntax::ERROR;
+        size_t length = 0;
+        for(int c = getByte(); c >= 0; c = getByte())
+        {
+            value.push_back(static_cast<char>(c));
+            state = syntax.transition(state, static_cast<unsigned char>(c));
+            if(state < 0)
+                break;
+            if(syntax.accepted(state) != Syntax::ERROR)
+            {
+                token = syntax.accepted(state);
+                length = value.size();
+            }
+        }
+
+        if(value.empty())
+            return Syntax::END;
+        if(token == Syntax::ERROR)
+            length = 1;
+
+        // characters read after the longest token
+        if(length < value.size())
+        {
+            pending.erase(0, pendingPos);
+            pending.insert(0, value, length, std::string::npos);
+            pendingPos = 0;
+            value.resize(length);
+        }
+
+        if(!syntax.isIgnored(token))
+            return token;
+    }
+}
+
+const std::string& TableLexer::getValue() const
+{
+    return value;
+}
+
+
+//****************************** Private functions *******************************//
+int TableLexer::getByte()
+{
+    if(pendingPos < pending.size())
+        return static_cast<unsigned char>(pending[pendingPos++]);
+    return buf->sbumpc();
+}
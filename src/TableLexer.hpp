@@ -0,0 +1,62 @@
+#ifndef TABLELEXER_H
+#define TABLELEXER_H
+
+#include "Syntax.hpp"
+#include <istream>
+#include <string>
+
+/*! \brief Generic lexer engine driven by the tables of a Syntax object.
+ *
+ * The lexer reads the longest text matching a token of the language, using only the transition table
+ * of the syntax. Tokens marked as ignored (blanks, comments) are skipped.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * Syntax json = Syntax::loadFile("syntax/json.yml");
+ * TableLexer lexer(json, stream);
+ * for(int t = lexer.next(); t != Syntax::END; t = lexer.next())
+ *     std::cout << json.tokenName(t) << " : " << lexer.getValue() << std::endl;
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The tables are loaded at run time, so TableLexer is meant for the languages without a dedicated reader.
+ * BasicReader doesn't use it: its character loops are specialized at compile time by its dialect policy and
+ * build the values while scanning, without a token stream between them.
+ * \see Syntax
+ */
+class TableLexer
+{
+    public:
+        /*! \brief Construct a lexer reading the input stream with the specified syntax.
+         *
+         * The syntax object must outlive the lexer.
+         * \param syntax The compiled syntax of the language.
+         * \param input The input stream to read.
+         */
+        TableLexer(const Syntax& syntax, std::istream& input);
+
+        /*! \brief Read the next token.
+         *
+         * \return The number of the token, Syntax::END at the end of the stream, or Syntax::ERROR if the
+         * next character doesn't start any token. In this case, the character is skipped.
+         */
+        int next();
+
+        /*! \brief Get the text of the last token read.
+         */
+        const std::string& getValue() const;
+
+
+
+
+    private:
+        const Syntax& syntax;   //!< The tables of the language.
+        std::streambuf* buf;    //!< The buffer of the input stream.
+        std::string value;      //!< The text of the last token.
+        std::string pending;    //!< Characters read after the last token, to read again.
+        size_t pendingPos;      //!< Position of the next character in pending.
+
+        /*! Read the next byte, from pending first. Returns a negative value at the end of the stream.
+         */
+        int getByte();
+};
+
+#endif // TABLELEXER_H
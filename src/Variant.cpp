@@ -1,4 +1,5 @@
 #include "Variant.hpp"
+#include "Shape.hpp"
 #include <stdexcept>
 
 //********************************************----------------------------*********************************************//
@@ -14,16 +15,24 @@ Variant::Variant() : type(Variant::NULLTYPE) {
 
 Variant::Variant(const Variant &v)
 {
-    switch(type)
+    switch(v.type)
     {
         case Variant::STRING:
             value.String = new std::string(*v.value.String);
             break;
         case Variant::SEQUENCE:
-            value.Array = new ArrayType(*v.value.Array);
+            if(v.packed)
+                value.Packed = new PackedArray(*v.value.Packed);
+            else
+                value.Array = new ArrayType(*v.value.Array);
+            packed = v.packed;
             break;
         case Variant::MAP:
-            value.Map = new MapType(*v.value.Map);
+            if(v.packed)
+                value.Shaped = new ShapedMap(*v.value.Shaped);
+            else
+                value.Map = new MapType(*v.value.Map);
+            packed = v.packed;
             break;
         default:
             value = v.value;
@@ -31,13 +40,15 @@ Variant::Variant(const Variant &v)
     type = v.getType();
 }
 
-Variant::Variant(Variant &&v)
+Variant::Variant(Variant &&v) noexcept
 {
     type = v.getType();
     value = v.value;
+    packed = v.packed;
 
     v.type = Variant::NULLTYPE;
     v.value.Long = 0;
+    v.packed = false;
 }
 
 Variant::Variant(const bool var) : type(Variant::BOOL) {
@@ -58,18 +69,27 @@ Variant::Variant(const float var) : type(Variant::FLOAT) {
 Variant::Variant(const double var) : type(Variant::DOUBLE) {
     value.Double=var; }
 
-Variant::Variant(const std::string var) : type(Variant::STRING) {
+Variant::Variant(const std::string& var) : type(Variant::STRING) {
     value.String = new std::string(var); }
 
+Variant::Variant(std::string&& var) : type(Variant::STRING) {
+    value.String = new std::string(std::move(var)); }
+
 Variant::Variant(const char* var) : type(Variant::STRING) {
     value.String = new std::string(var); }
 
-Variant::Variant(const ArrayType var) : type(Variant::SEQUENCE) {
+Variant::Variant(const ArrayType& var) : type(Variant::SEQUENCE) {
     value.Array = new ArrayType(var); }
 
-Variant::Variant(const MapType var) : type(Variant::MAP) {
+Variant::Variant(ArrayType&& var) : type(Variant::SEQUENCE) {
+    value.Array = new ArrayType(std::move(var)); }
+
+Variant::Variant(const MapType& var) : type(Variant::MAP) {
     value.Map = new MapType(var); }
 
+Variant::Variant(MapType&& var) : type(Variant::MAP) {
+    value.Map = new MapType(std::move(var)); }
+
 
 
 //********************************************----------------*********************************************//
@@ -122,6 +142,8 @@ Variant& Variant::operator[] (const size_t key)
 {
     if(type!=Variant::SEQUENCE)
         throw std::logic_error("Variant::operator[](size_t) : wrong type");
+    if(packed)
+        unpack();
     return value.Array->at(key);
 }
 
@@ -129,35 +151,122 @@ const Variant& Variant::operator[] (const size_t key) const
 {
     if(type!=Variant::SEQUENCE)
         throw std::logic_error("Variant::operator[](size_t) : wrong type");
+    if(packed)
+    {
+        if(key >= value.Packed->size())
+            throw std::out_of_range("Variant::operator[](size_t) : out of range");
+        return value.Packed->element(key);
+    }
     return value.Array->at(key);
 }
 
-Variant& Variant::operator[] (const std::string key)
+Variant& Variant::operator[] (std::string_view key)
+{
+    const Variant& slot = static_cast<const Variant&>(*this)[key];
+    if(packed)
+        value.Shaped->dropEntries(); // the value can be modified
+    return const_cast<Variant&>(slot);
+}
+
+const Variant& Variant::operator[] (std::string_view key) const
 {
     if(type!=Variant::MAP)
         throw std::logic_error("Variant::operator[](std::string) : wrong type");
-    return value.Map->at(key);
+    if(packed)
+    {
+        int slot = value.Shaped->shape->find(key);
+        if(slot < 0)
+            throw std::out_of_range("Variant::operator[](std::string) : unknown key");
+        return value.Shaped->values[slot];
+    }
+    MapType::const_iterator it = value.Map->find(key);
+    if(it == value.Map->end())
+        throw std::out_of_range("Variant::operator[](std::string) : unknown key");
+    return it->second;
 }
 
-const Variant& Variant::operator[] (const std::string key) const
+Variant* Variant::find(std::string_view key)
+{
+    const Variant* slot = static_cast<const Variant&>(*this).find(key);
+    if(slot && packed)
+        value.Shaped->dropEntries(); // the value can be modified
+    return const_cast<Variant*>(slot);
+}
+
+const Variant* Variant::find(std::string_view key) const
 {
     if(type!=Variant::MAP)
-        throw std::logic_error("Variant::operator[](std::string) : wrong type");
-    return value.Map->at(key);
+        return 0;
+    if(packed)
+    {
+        int slot = value.Shaped->shape->find(key);
+        return slot < 0 ? 0 : &value.Shaped->values[slot];
+    }
+    MapType::const_iterator it = value.Map->find(key);
+    return it == value.Map->end() ? 0 : &it->second;
 }
 
+Variant& Variant::operator[] (FieldLookup& lookup)
+{
+    const Variant& slot = static_cast<const Variant&>(*this)[lookup];
+    if(packed)
+        value.Shaped->dropEntries(); // the value can be modified
+    return const_cast<Variant&>(slot);
+}
 
-Variant::ArrayType& Variant::getArray() const
+const Variant& Variant::operator[] (FieldLookup& lookup) const
+{
+    if(type!=Variant::MAP)
+        throw std::logic_error("Variant::operator[](FieldLookup) : wrong type");
+    if(!packed)
+        return (*this)[std::string_view(lookup.name)];
+
+    const std::shared_ptr<const Shape>& shape = value.Shaped->shape;
+    if(lookup.shape != shape)
+    {
+        int slot = shape->find(lookup.name);
+        if(slot < 0)
+            throw std::out_of_range("Variant::operator[](FieldLookup) : unknown key");
+        lookup.shape = shape;
+        lookup.slot = slot;
+    }
+    return value.Shaped->values[lookup.slot];
+}
+
+
+Variant::ArrayType& Variant::getArray()
 {
 	if(type!=Variant::SEQUENCE)
 		throw std::logic_error("Variant::getArray : wrong type");
+	if(packed)
+		unpack();
 	return *value.Array;
 }
 
-Variant::MapType& Variant::getMap() const
+const Variant::ArrayType& Variant::getArray() const
+{
+	if(type!=Variant::SEQUENCE)
+		throw std::logic_error("Variant::getArray : wrong type");
+	if(packed)
+		return value.Packed->getElements();
+	return *value.Array;
+}
+
+Variant::MapType& Variant::getMap()
+{
+	if(type!=Variant::MAP)
+		throw std::logic_error("Variant::getMap : wrong type");
+	if(packed)
+		unshape();
+	return *value.Map;
+}
+
+const Variant::MapType& Variant::getMap() const
 {
 	if(type!=Variant::MAP)
 		throw std::logic_error("Variant::getMap : wrong type");
+	if(packed)
+		return value.Shaped->getEntries();
 	return *value.Map;
 }
 
@@ -166,16 +275,73 @@ size_t Variant::size() const
     switch(type)
     {
         case Variant::SEQUENCE:
-            return value.Array->size();
+            return packed ? value.Packed->size() : value.Array->size();
             break;
         case Variant::MAP:
-            return value.Map->size();
+            return packed ? value.Shaped->values.size() : value.Map->size();
             break;
         default:
             return 0;
     }
 }
 
+bool Variant::isPacked() const {
+    return type==Variant::SEQUENCE && packed; }
+
+Variant::VariantType Variant::getPackedType() const {
+    return isPacked() ? value.Packed->elementType : Variant::UNDEFINED; }
+
+ArrayView<int> Variant::getIntArray() const
+{
+    if(getPackedType()!=Variant::INT)
+        throw std::logic_error("Variant::getIntArray : wrong type");
+    return ArrayView<int>(value.Packed->ints.data(), value.Packed->ints.size());
+}
+
+ArrayView<long long> Variant::getLongArray() const
+{
+    if(getPackedType()!=Variant::LONG)
+        throw std::logic_error("Variant::getLongArray : wrong type");
+    return ArrayView<long long>(value.Packed->longs.data(), value.Packed->longs.size());
+}
+
+ArrayView<float> Variant::getFloatArray() const
+{
+    if(getPackedType()!=Variant::FLOAT)
+        throw std::logic_error("Variant::getFloatArray : wrong type");
+    return ArrayView<float>(value.Packed->floats.data(), value.Packed->floats.size());
+}
+
+ArrayView<double> Variant::getDoubleArray() const
+{
+    if(getPackedType()!=Variant::DOUBLE)
+        throw std::logic_error("Variant::getDoubleArray : wrong type");
+    return ArrayView<double>(value.Packed->doubles.data(), value.Packed->doubles.size());
+}
+
+bool Variant::isShaped() const {
+    return type==Variant::MAP && packed; }
+
+std::shared_ptr<const Shape> Variant::getShape() const {
+    return isShaped() ? value.Shaped->shape : std::shared_ptr<const Shape>(); }
+
+ArrayView<Variant> Variant::getShapedValues() const
+{
+    if(!isShaped())
+        throw std::logic_error("Variant::getShapedValues : wrong type");
+    return ArrayView<Variant>(value.Shaped->values.data(), value.Shaped->values.size());
+}
+
+void Variant::reserve(size_t size)
+{
+    if(type==Variant::SEQUENCE && packed)
+        value.Packed->reserve(size);
+    else if(type==Variant::SEQUENCE)
+        value.Array->reserve(size);
+    else if(type!=Variant::MAP)
+        wrongType("Variant::reserve : wrong type");
+}
+
 
 
 //********************************************----------------*********************************************//
@@ -189,10 +355,18 @@ void Variant::setToNull()
             delete value.String;
             break;
         case Variant::SEQUENCE:
-            delete value.Array;
+            if(packed)
+                delete value.Packed;
+            else
+                delete value.Array;
+            packed = false;
             break;
         case Variant::MAP:
-            delete value.Map;
+            if(packed)
+                delete value.Shaped;
+            else
+                delete value.Map;
+            packed = false;
             break;
         default:
             break;
@@ -203,32 +377,28 @@ void Variant::setToNull()
 
 Variant& Variant::operator= (const Variant &v)
 {
-    setToNull();
-    type = v.getType();
-    switch(type)
-    {
-        case Variant::STRING:
-            value.String = new std::string(*v.value.String);
-            break;
-        case Variant::SEQUENCE:
-            value.Array = new ArrayType(*v.value.Array);
-            break;
-        case Variant::MAP:
-            value.Map = new MapType(*v.value.Map);
-            break;
-        default:
-            value = v.value;
-    }
-    return *this;
+    // copy before freeing, v can be inside this Variant
+    Variant copy(v);
+    return *this = std::move(copy);
 }
 
-Variant& Variant::operator= (Variant &&v)
+Variant& Variant::operator= (Variant &&v) noexcept
 {
-    type = v.getType();
-    value = v.value;
+    if(this == &v)
+        return *this;
 
+    // detach before freeing, v can be inside this Variant
+    Var moved = v.value;
+    VariantType movedType = v.type;
+    bool movedPacked = v.packed;
     v.type = Variant::NULLTYPE;
     v.value.Long = 0;
+    v.packed = false;
+
+    setToNull();
+    type = movedType;
+    value = moved;
+    packed = movedPacked;
     return *this;
 }
 
@@ -274,27 +444,54 @@ Variant& Variant::operator= (const double var)
     return *this;
 }
 
-Variant& Variant::operator= (const std::string var)
+Variant& Variant::operator= (const std::string& var)
 {
-    setToNull();
-    type=Variant::STRING; value.String = new std::string(var);
+    if(type==Variant::STRING) // reuse the storage of the string
+        *value.String = var;
+    else
+    {
+        setToNull();
+        type=Variant::STRING; value.String = new std::string(var);
+    }
     return *this;
 }
 
-Variant& Variant::operator= (const ArrayType var)
+Variant& Variant::operator= (std::string&& var)
 {
-    setToNull();
-    type=Variant::SEQUENCE; value.Array = new ArrayType(var);
+    if(type==Variant::STRING)
+        *value.String = std::move(var);
+    else
+    {
+        setToNull();
+        type=Variant::STRING; value.String = new std::string(std::move(var));
+    }
     return *this;
 }
 
-Variant& Variant::operator= (const MapType var)
+Variant& Variant::operator= (const char* var)
 {
-    setToNull();
-    type=Variant::MAP; value.Map = new MapType(var);
+    if(type==Variant::STRING)
+        *value.String = var;
+    else
+    {
+        setToNull();
+        type=Variant::STRING; value.String = new std::string(var);
+    }
     return *this;
 }
 
+Variant& Variant::operator= (const ArrayType& var) {
+    return *this = Variant(var); }
+
+Variant& Variant::operator= (ArrayType&& var) {
+    return *this = Variant(std::move(var)); }
+
+Variant& Variant::operator= (const MapType& var) {
+    return *this = Variant(var); }
+
+Variant& Variant::operator= (MapType&& var) {
+    return *this = Variant(std::move(var)); }
+
 
 Variant& Variant::createArray()
 {
@@ -312,35 +509,187 @@ Variant& Variant::createMap()
     return *this;
 }
 
+Variant& Variant::createPackedArray(VariantType elementType)
+{
+    if(elementType!=Variant::INT && elementType!=Variant::LONG &&
+       elementType!=Variant::FLOAT && elementType!=Variant::DOUBLE)
+        throw std::invalid_argument("Variant::createPackedArray : wrong element type");
+    setToNull();
+    type=Variant::SEQUENCE;
+    value.Packed = new PackedArray();
+    value.Packed->elementType = elementType;
+    packed = true;
+    return *this;
+}
 
-Variant& Variant::insert(const Variant val)
+bool Variant::insertPacked(const Variant& val)
 {
-    if(val.getType()==Variant::STRING && type==Variant::MAP)
+    if(type!=Variant::SEQUENCE)
+        return false;
+    if(!packed)
     {
-        (*value.Map)[val.toString()];
-        return (*value.Map)[val.toString()];
+        if(!value.Array->empty() || (val.type!=Variant::INT && val.type!=Variant::LONG &&
+                                     val.type!=Variant::FLOAT && val.type!=Variant::DOUBLE))
+            return false;
+        // keep the storage reserved for the array
+        size_t capacity = value.Array->capacity();
+        createPackedArray(val.type);
+        value.Packed->reserve(capacity);
     }
-    else
+
+    PackedArray& array = *value.Packed;
+    if(val.type!=array.elementType)
+        return false;
+    array.dropElements();
+    switch(array.elementType)
+    {
+        case Variant::INT:      array.ints.push_back(val.value.Int); break;
+        case Variant::LONG:     array.longs.push_back(val.value.Long); break;
+        case Variant::FLOAT:    array.floats.push_back(val.value.Float); break;
+        default:                array.doubles.push_back(val.value.Double); break;
+    }
+    return true;
+}
+
+void Variant::unpack()
+{
+    PackedArray* array = value.Packed;
+    ArrayType* elements = new ArrayType();
+    elements->reserve(array->size());
+    switch(array->elementType)
+    {
+        case Variant::INT:
+            elements->assign(array->ints.begin(), array->ints.end());
+            break;
+        case Variant::LONG:
+            elements->assign(array->longs.begin(), array->longs.end());
+            break;
+        case Variant::FLOAT:
+            elements->assign(array->floats.begin(), array->floats.end());
+            break;
+        default:
+            elements->assign(array->doubles.begin(), array->doubles.end());
+            break;
+    }
+    delete array;
+    value.Array = elements;
+    packed = false;
+}
+
+void Variant::shapeAs(std::shared_ptr<const Shape>& shape)
+{
+    if(type!=Variant::MAP)
+        throw std::logic_error("Variant::shapeAs : wrong type");
+    if(packed)
     {
-        if(type!=Variant::SEQUENCE)
-            throw std::logic_error("Variant::insert(Variant&) : wrong type");
-        value.Array->push_back(Variant()); // Don't remove this!!!!
-        value.Array->back() = val; // Don't remove this!!!!
-        return value.Array->back();
+        if(!shape)
+            shape = value.Shaped->shape;
+        return;
     }
+
+    MapType* map = value.Map;
+    if(!shape || !shape->sameKeys(*map))
+        shape = std::make_shared<const Shape>(*map);
+    ShapedMap* shaped = new ShapedMap();
+    shaped->shape = shape;
+    shaped->values.reserve(map->size());
+    for(MapType::iterator it = map->begin(); it != map->end(); ++it)
+        shaped->values.push_back(std::move(it->second));
+    delete map;
+    value.Shaped = shaped;
+    packed = true;
+}
+
+void Variant::unshape()
+{
+    ShapedMap* shaped = value.Shaped;
+    MapType* map = new MapType();
+    const Shape& shape = *shaped->shape;
+    for(size_t i = 0; i < shaped->values.size(); i++)
+        map->emplace_hint(map->end(), shape.key(i), std::move(shaped->values[i]));
+    delete shaped;
+    value.Map = map;
+    packed = false;
+}
+
+Variant* Variant::shapedSlot(std::string_view key)
+{
+    int slot = value.Shaped->shape->find(key);
+    if(slot >= 0)
+    {
+        value.Shaped->dropEntries();
+        return &value.Shaped->values[slot];
+    }
+    unshape();
+    return 0;
+}
+
+
+Variant& Variant::insert(const Variant& val)
+{
+    if(val.getType()==Variant::STRING && type==Variant::MAP)
+        return emplaceKey(*val.value.String);
+    if(type!=Variant::SEQUENCE)
+        wrongType("Variant::insert(Variant&) : wrong type");
+    if(packed)
+        unpack();
+    value.Array->push_back(val);
+    return value.Array->back();
+}
+
+Variant& Variant::insert(Variant&& val)
+{
+    if(val.getType()==Variant::STRING && type==Variant::MAP)
+        return emplaceKey(*val.value.String);
+    if(type!=Variant::SEQUENCE)
+        wrongType("Variant::insert(Variant&) : wrong type");
+    if(packed)
+        unpack();
+    value.Array->push_back(std::move(val));
+    return value.Array->back();
 }
 
-Variant& Variant::insert(const std::string key, const Variant val)
+Variant& Variant::insert(const std::string& key, const Variant& val)
 {
     if(type!=Variant::MAP)
-        throw std::logic_error("Variant::insert(string,Variant&) : wrong type");
-    if(val.getType()==Variant::SEQUENCE || val.getType()==Variant::MAP)
+        wrongType("Variant::insert(string,Variant&) : wrong type");
+    return emplace(key, val);
+}
+
+Variant& Variant::insert(std::string&& key, Variant&& val)
+{
+    if(type!=Variant::MAP)
+        wrongType("Variant::insert(string,Variant&) : wrong type");
+    if(packed)
     {
-        (*value.Map)[key];
-        (*value.Map)[key] = val;
+        Variant* slot = shapedSlot(key);
+        if(slot)
+            return *slot = std::move(val);
     }
+    MapType::iterator it = value.Map->lower_bound(key);
+    if(it != value.Map->end() && it->first == key)
+        it->second = std::move(val);
     else
-        (*value.Map)[key] = val;
-    return (*value.Map)[key];
+        it = value.Map->emplace_hint(it, Key(std::move(key)), std::move(val));
+    return it->second;
 }
 
+
+Variant& Variant::emplaceKey(std::string_view key)
+{
+    if(packed)
+    {
+        Variant* slot = shapedSlot(key);
+        if(slot)
+            return *slot;
+    }
+    MapType::iterator it = value.Map->lower_bound(key);
+    if(it == value.Map->end() || !(it->first == key))
+        it = value.Map->emplace_hint(it, Key(key), Variant());
+    return it->second;
+}
+
+void Variant::wrongType(const char* msg)
+{
+    throw std::logic_error(msg);
+}
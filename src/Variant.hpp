@@ -2,8 +2,14 @@
 #define VARIANT_H
 
 #include <string>
+#include <string_view>
+#include "Key.hpp"
 #include <map>
-#include <deque>
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <memory>
+#include <atomic>
 
 /*
 class _Variant_iterator
@@ -13,6 +19,31 @@ class _Variant_iterator
 
 
 
+class Shape;
+class FieldLookup;
+
+
+/*! \brief Read-only view on contiguous elements, like the content of a packed array of a Variant.
+ */
+template<class T>
+class ArrayView
+{
+    public:
+        ArrayView(const T* data, size_t size) : first(data), count(size) {}
+
+        const T* data() const { return first; }                     //!< Get the first element.
+        size_t size() const { return count; }                       //!< Get the number of elements.
+        bool empty() const { return count == 0; }                   //!< Check if there is no element.
+        const T* begin() const { return first; }                    //!< Get an iterator on the first element.
+        const T* end() const { return first + count; }              //!< Get an iterator after the last element.
+        const T& operator[] (size_t i) const { return first[i]; }   //!< Get an element, without bounds checking.
+
+    private:
+        const T* first;
+        size_t count;
+};
+
+
 /*! \brief Class which can contain multiple type of variable.
  *
  * This class is a generic handler for all common type of variable, and especially the ones usable in the JSON format.
@@ -85,6 +116,32 @@ class _Variant_iterator
  * }
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  *
+ * Packed arrays :
+ * -------------------
+ *
+ * An array of numbers of the same type (INT, LONG, FLOAT or DOUBLE) can be stored packed: the numbers are kept in a
+ * contiguous C++ array insteed of a Variant for each element. The readers pack the homogeneous arrays they read.
+ * A packed array is still a SEQUENCE, and its numbers can be read with getIntArray(), getLongArray(),
+ * getFloatArray() or getDoubleArray(), which is the fast path. The const accessors never convert it: the const
+ * access operator builds the read-only elements by blocks, only for the blocks accessed, and the const getArray()
+ * builds a read-only copy of the whole array, several times larger than the numbers. Both are kept with the
+ * numbers until the array is modified. The non-const accessors and the insert methods convert it to a regular
+ * array first.
+ *
+ * Shaped maps :
+ * -------------------
+ *
+ * The maps of an array of records with the same keys can share a Shape: the keys are stored once in the shape and
+ * each map only stores its values, in a vector (see shapeAs()). The readers share the shapes of the maps of an array
+ * which have the same keys.
+ * A shaped map is still a MAP, and its values are read and modified in place with the access operators. A
+ * FieldLookup remembers the slot of a key, so the same field of many records is accessed without searching the key.
+ * The const getMap() returns a read-only copy of the entries, built once on the first call and dropped by the next
+ * non-const access to a value, which invalidates the references into it. Adding a key or calling the non-const
+ * getMap() converts it to a regular map first.
+ *
+ * The const methods never convert a packed array or a shaped map, so a tree which is not modified can be read by
+ * many threads at once. A FrozenDocument is still more compact and faster to read.
  */
 class Variant
 {
@@ -111,8 +168,8 @@ class Variant
             UNDEFINED   //!< The node doesn't exist
         };
 
-        typedef std::map<std::string,Variant> MapType;  //!< A typedef for the type of key/value map used
-        typedef std::deque<Variant> ArrayType;          //!< A typedef for the type of dynamic array used
+        typedef std::map<Key,Variant,std::less<> > MapType;  //!< A typedef for the type of key/value map used, with heterogeneous lookup
+        typedef std::vector<Variant> ArrayType;         //!< A typedef for the type of dynamic array used
 
         //**********************************************************************************************//
         //********************************  Constructors / Destructors  ********************************//
@@ -130,7 +187,7 @@ class Variant
         /*! \brief x
          *
          */
-        Variant(Variant &&v);
+        Variant(Variant &&v) noexcept;
 
         /*! \brief x
          *
@@ -165,7 +222,11 @@ class Variant
         /*! \brief x
          *
          */
-        Variant(const std::string var);
+        Variant(const std::string& var);
+
+        /*! \brief Construct a string Variant taking the content of _var_.
+         */
+        Variant(std::string&& var);
 
         /*! \brief x
          *
@@ -175,12 +236,20 @@ class Variant
         /*! \brief x
          *
          */
-        Variant(const ArrayType var);
+        Variant(const ArrayType& var);
+
+        /*! \brief Construct an array Variant taking the content of _var_.
+         */
+        Variant(ArrayType&& var);
 
         /*! \brief x
          *
          */
-        Variant(const MapType var);
+        Variant(const MapType& var);
+
+        /*! \brief Construct a map Variant taking the content of _var_.
+         */
+        Variant(MapType&& var);
 
         /*! \brief x
          *
@@ -254,30 +323,67 @@ class Variant
          */
         Variant& operator[] (const size_t key);
 
-        /*! \brief x
+        /*! \brief Get an element of an array.
          *
+         * The element of a packed array is read from a read-only block of elements, built on the first access to
+         * the block, the array stays packed. Use getIntArray() and the other views to read many numbers.
+         * \throw std::out_of_range is thrown if _key_ is not a valid index.
          */
         const Variant& operator[] (const size_t key) const;
 
-        /*! \brief x
+        /*! \brief Get the value of a key of a map.
          *
+         * The key is looked up without building a std::string. As the value can be modified, the read-only copy of
+         * the entries of a shaped map is dropped: the references obtained from getMap() const are invalidated.
+         * \throw std::out_of_range is thrown if the key doesn't exist.
          */
-        Variant& operator[] (const std::string key);
+        Variant& operator[] (std::string_view key);
 
         /*! \brief x
          *
          */
-        const Variant& operator[] (const std::string key) const;
+        const Variant& operator[] (std::string_view key) const;
 
-        /*! \brief x
+        /*! \brief Get the value of a key of a map, without exception.
          *
+         * Like the non-const operator[], it invalidates the references obtained from getMap() const.
+         * \return The value of _key_, or a null pointer if the Variant is not a map or the key doesn't exist.
          */
-        ArrayType& getArray() const;
+        Variant* find(std::string_view key);
 
         /*! \brief x
          *
          */
-        MapType& getMap() const;
+        const Variant* find(std::string_view key) const;
+
+        /*! \brief Get the elements of an array, to modify them.
+         *
+         * A packed array is converted to a regular array first.
+         */
+        ArrayType& getArray();
+
+        /*! \brief Get the elements of an array.
+         *
+         * The elements of a packed array are a read-only copy built on the first call, the array stays packed.
+         * It is the slow path: the copy is kept until the array is modified. Use getIntArray() and the other views
+         * to read the numbers in place.
+         */
+        const ArrayType& getArray() const;
+
+        /*! \brief Get the entries of a map, to modify them.
+         *
+         * A shaped map is converted to a regular map first.
+         */
+        MapType& getMap();
+
+        /*! \brief Get the entries of a map.
+         *
+         * The entries of a shaped map are a read-only copy built on the first call, the map stays shaped. The copy
+         * is dropped when a value is accessed through a non-const method (operator[], find(), getMap()...), so the
+         * references to the entries returned before are invalidated, even if no key is added. To avoid the copy,
+         * read the map with getShape() and getShapedValues().
+         */
+        const MapType& getMap() const;
 
 
         /*! \brief x
@@ -285,6 +391,71 @@ class Variant
          */
         size_t size() const;
 
+        /*! \brief Check if the Variant is a packed array.
+         */
+        bool isPacked() const;
+
+        /*! \brief Get the type of the elements of a packed array.
+         * \return The type of the elements, or UNDEFINED if the Variant is not a packed array.
+         */
+        VariantType getPackedType() const;
+
+        /*! \brief Get the elements of a packed array of INT.
+         * \throw std::logic_error is thrown if the Variant is not a packed array of INT.
+         */
+        ArrayView<int> getIntArray() const;
+
+        /*! \brief Get the elements of a packed array of LONG.
+         * \throw std::logic_error is thrown if the Variant is not a packed array of LONG.
+         */
+        ArrayView<long long> getLongArray() const;
+
+        /*! \brief Get the elements of a packed array of FLOAT.
+         * \throw std::logic_error is thrown if the Variant is not a packed array of FLOAT.
+         */
+        ArrayView<float> getFloatArray() const;
+
+        /*! \brief Get the elements of a packed array of DOUBLE.
+         * \throw std::logic_error is thrown if the Variant is not a packed array of DOUBLE.
+         */
+        ArrayView<double> getDoubleArray() const;
+
+        /*! \brief Reserve the storage for _size_ elements in an array.
+         *
+         * The elements of an array are contiguous, so the storage should be reserved when the final size is known
+         * to avoid the reallocations. Maps are made of independent nodes and ignore this call.
+         * \throw std::logic_error is thrown if the Variant is not a container.
+         */
+        void reserve(size_t size);
+
+        /*! \brief Check if the Variant is a shaped map.
+         */
+        bool isShaped() const;
+
+        /*! \brief Get the shape of a shaped map.
+         * \return The shape, or a null pointer if the Variant is not a shaped map.
+         */
+        std::shared_ptr<const Shape> getShape() const;
+
+        /*! \brief Get the values of a shaped map, in the order of the keys of its shape.
+         * \throw std::logic_error is thrown if the Variant is not a shaped map.
+         */
+        ArrayView<Variant> getShapedValues() const;
+
+        /*! \brief Get the value of a key of a map, with the slot cached in _lookup_.
+         *
+         * Like the non-const operator[], it invalidates the references obtained from getMap() const.
+         * \throw std::out_of_range is thrown if the key doesn't exist.
+         * \see FieldLookup
+         */
+        Variant& operator[] (FieldLookup& lookup);
+
+        /*! \brief Get the value of a key of a map, with the slot cached in _lookup_.
+         * \throw std::out_of_range is thrown if the key doesn't exist.
+         * \see FieldLookup
+         */
+        const Variant& operator[] (FieldLookup& lookup) const;
+
 
 
 
@@ -305,7 +476,7 @@ class Variant
         /*! \brief x
          *
          */
-        Variant& operator= (Variant &&v);
+        Variant& operator= (Variant &&v) noexcept;
 
         /*! \brief x
          *
@@ -340,17 +511,34 @@ class Variant
         /*! \brief x
          *
          */
-        Variant& operator= (const std::string var);
+        Variant& operator= (const std::string& var);
+
+        /*! \brief Set the Variant to a string, taking the content of _var_.
+         */
+        Variant& operator= (std::string&& var);
+
+        /*! \brief x
+         *
+         */
+        Variant& operator= (const char* var);
 
         /*! \brief x
          *
          */
-        Variant& operator= (const ArrayType var);
+        Variant& operator= (const ArrayType& var);
+
+        /*! \brief Set the Variant to an array, taking the content of _var_.
+         */
+        Variant& operator= (ArrayType&& var);
 
         /*! \brief x
          *
          */
-        Variant& operator= (const MapType var);
+        Variant& operator= (const MapType& var);
+
+        /*! \brief Set the Variant to a map, taking the content of _var_.
+         */
+        Variant& operator= (MapType&& var);
 
 
         /*! \brief x
@@ -363,21 +551,83 @@ class Variant
          */
         Variant& createMap();
 
+        /*! \brief Set the Variant to an empty packed array of numbers of type _elementType_.
+         * \throw std::invalid_argument is thrown if _elementType_ is not INT, LONG, FLOAT or DOUBLE.
+         */
+        Variant& createPackedArray(VariantType elementType);
 
-        /*! \brief x
+        /*! \brief Append a number at the end of a packed array.
          *
+         * An empty array is packed with the type of _val_.
+         * \return false if _val_ can't be packed in this array: the Variant is not an empty or packed array, or _val_
+         * is not a number of the type of the packed elements. In this case, nothing is done.
          */
-        Variant& insert(const Variant val);
+        bool insertPacked(const Variant& val);
 
-        /*! \brief x
+        /*! \brief Convert a map to a shaped map.
+         *
+         * If _shape_ has the keys of the map, the map uses it. Otherwise a new shape is created and stored in
+         * _shape_, so the next maps with the same keys share it. A map already shaped is not modified, and sets
+         * _shape_ if it is null.
+         * \throw std::logic_error is thrown if the Variant is not a map.
+         */
+        void shapeAs(std::shared_ptr<const Shape>& shape);
+
+
+        /*! \brief Append a copy of _val_ at the end of an array.
+         *
+         * If the Variant is a map and _val_ a string, the value of the key _val_ is returned,
+         * and created if it doesn't exist.
+         * \throw std::logic_error is thrown if the Variant is not an array.
+         */
+        Variant& insert(const Variant& val);
+
+        /*! \brief Append _val_ at the end of an array, moving its content.
+         * \see insert(const Variant&)
+         */
+        Variant& insert(Variant&& val);
+
+        /*! \brief Set the value of _key_ in a map to a copy of _val_.
+         *
+         * The key is looked up once, and created if it doesn't exist.
+         * \throw std::logic_error is thrown if the Variant is not a map.
+         */
+        Variant& insert(const std::string& key, const Variant& val);
+
+        /*! \brief Set the value of _key_ in a map to _val_, moving the key and the value.
+         * \see insert(const std::string&, const Variant&)
+         */
+        Variant& insert(std::string&& key, Variant&& val);
+
+        /*! \brief Construct a new element at the end of an array.
          *
+         * The element is constructed in place with the arguments _args_ (no argument for a null value).
+         * \return The new element.
+         * \throw std::logic_error is thrown if the Variant is not an array.
          */
-        Variant& insert(const std::string key, const Variant val);
+        template<class... Args>
+        Variant& emplaceBack(Args&&... args);
+
+        /*! \brief Construct the value of _key_ in a map.
+         *
+         * The value is constructed in place with the arguments _args_ (no argument for a null value).
+         * The key is looked up once, without building a std::string if it already exists. If the key exists,
+         * its value is replaced.
+         * \param key The key: a Key (an interned key from a KeyTable shares its storage with the map), a string,
+         * a std::string_view or a C string.
+         * \return The value of the key.
+         * \throw std::logic_error is thrown if the Variant is not a map.
+         */
+        template<class KeyType, class... Args>
+        Variant& emplace(const KeyType& key, Args&&... args);
 
 
 
 
     private:
+        struct PackedArray;
+        struct ShapedMap;
+
         /*! The value of the object.
          *  The Variant can hold just one value at the same time.
          */
@@ -391,10 +641,73 @@ class Variant
             std::string* String;
             ArrayType* Array;
             MapType* Map;
+            PackedArray* Packed;
+            ShapedMap* Shaped;
         } Var;
 
         Var value;
 		VariantType type;   //!< The type of the value saved.
+        bool packed = false;    //!< The array is stored in value.Packed, or the map in value.Shaped.
+
+
+        /*! Convert a packed array to a regular array.
+         */
+        void unpack();
+
+        /*! Convert a shaped map to a regular map.
+         */
+        void unshape();
+
+        /*! Get the slot of _key_ in a shaped map. If the key doesn't exist, the map is converted to a regular
+         *  map and null is returned.
+         */
+        Variant* shapedSlot(std::string_view key);
+
+        /*! Get the value of _key_ in the map, created if it doesn't exist.
+         */
+        Variant& emplaceKey(std::string_view key);
+
+
+        /*! Throw an std::logic_error with the message _msg_.
+         *  Kept out of line so the templates stay small.
+         */
+        [[noreturn]] static void wrongType(const char* msg);
+
+        friend class VariantPool;
 };
 
+
+//****************************** Templates *******************************//
+template<class... Args>
+Variant& Variant::emplaceBack(Args&&... args)
+{
+    if(type!=Variant::SEQUENCE)
+        wrongType("Variant::emplaceBack : wrong type");
+    if(packed)
+        unpack();
+    value.Array->emplace_back(std::forward<Args>(args)...);
+    return value.Array->back();
+}
+
+template<class KeyType, class... Args>
+Variant& Variant::emplace(const KeyType& key, Args&&... args)
+{
+    if(type!=Variant::MAP)
+        wrongType("Variant::emplace : wrong type");
+    if(packed)
+    {
+        Variant* slot = shapedSlot(key);
+        if(slot)
+            return *slot = Variant(std::forward<Args>(args)...);
+    }
+    MapType::iterator it = value.Map->lower_bound(key);
+    if(it != value.Map->end() && it->first == key)
+        it->second = Variant(std::forward<Args>(args)...);
+    else
+        it = value.Map->emplace_hint(it, std::piecewise_construct,
+                                     std::forward_as_tuple(key),
+                                     std::forward_as_tuple(std::forward<Args>(args)...));
+    return it->second;
+}
+
 #endif // VARIANT_H
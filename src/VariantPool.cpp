@@ -0,0 +1,273 @@
+#include "VariantPool.hpp"
+#include "Shape.hpp"
+#include <stdexcept>
+
+namespace
+{
+    const size_t maxShapes = 64; //!< Number of shapes kept, they are searched linearly.
+}
+
+
+//******************************** Constructors *******************************//
+VariantPool::VariantPool(size_t maxObjects) :
+    maxObjects(maxObjects),
+    nextShape(0)
+{}
+
+VariantPool::~VariantPool()
+{
+    clear();
+}
+
+
+//****************************** Public functions *******************************//
+void VariantPool::release(Variant& value)
+{
+    switch(value.type)
+    {
+        case Variant::STRING:
+            if(strings.size() < maxObjects)
+            {
+                value.value.String->clear();
+                strings.push_back(value.value.String);
+                detach(value);
+                return;
+            }
+            break;
+        case Variant::SEQUENCE:
+            if(value.packed)
+            {
+                if(packedArrays.size() < maxObjects)
+                {
+                    value.value.Packed->clear();
+                    packedArrays.push_back(value.value.Packed);
+                    detach(value);
+                    return;
+                }
+            }
+            else
+            {
+                Variant::ArrayType* array = value.value.Array;
+                for(Variant::ArrayType::iterator it = array->begin(); it != array->end(); ++it)
+                    release(*it);
+                recycle(array);
+                detach(value);
+                return;
+            }
+            break;
+        case Variant::MAP:
+            if(value.packed)
+            {
+                Variant::ShapedMap* shaped = value.value.Shaped;
+                std::vector<Variant>& values = shaped->values;
+                for(std::vector<Variant>::iterator it = values.begin(); it != values.end(); ++it)
+                    release(*it);
+                if(shapedMaps.size() < maxObjects)
+                {
+                    // the shape is shared by other maps, the pool keeps the last ones in shapes
+                    shaped->dropEntries();
+                    shaped->values.clear();
+                    shaped->shape.reset();
+                    shapedMaps.push_back(shaped);
+                    detach(value);
+                    return;
+                }
+            }
+            else
+            {
+                Variant::MapType* map = value.value.Map;
+                for(Variant::MapType::iterator it = map->begin(); it != map->end(); ++it)
+                    release(it->second);
+                recycle(map);
+                detach(value);
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+    value.setToNull();
+}
+
+Variant& VariantPool::createArray(Variant& value)
+{
+    release(value);
+    if(arrays.empty())
+        return value.createArray();
+    value.value.Array = arrays.back();
+    value.type = Variant::SEQUENCE;
+    arrays.pop_back();
+    return value;
+}
+
+Variant& VariantPool::createMap(Variant& value)
+{
+    release(value);
+    if(maps.empty())
+        return value.createMap();
+    value.value.Map = maps.back();
+    value.type = Variant::MAP;
+    maps.pop_back();
+    return value;
+}
+
+Variant& VariantPool::assign(Variant& value, std::string_view text)
+{
+    if(value.type == Variant::STRING)
+    {
+        value.value.String->assign(text);
+        return value;
+    }
+    release(value);
+    if(strings.empty())
+        return value = std::string(text);
+    value.value.String = strings.back();
+    value.value.String->assign(text);
+    value.type = Variant::STRING;
+    strings.pop_back();
+    return value;
+}
+
+Variant& VariantPool::emplace(Variant& map, Key key)
+{
+    if(map.type != Variant::MAP)
+        throw std::logic_error("VariantPool::emplace : wrong type");
+    if(map.packed || nodes.empty())
+        return map.emplace(key);
+
+    Variant::MapType::iterator it = map.value.Map->lower_bound(key);
+    if(it != map.value.Map->end() && it->first == key)
+    {
+        release(it->second);
+        return it->second;
+    }
+    Variant::MapType::node_type node = std::move(nodes.back());
+    nodes.pop_back();
+    node.key() = std::move(key);
+    return map.value.Map->insert(it, std::move(node))->second;
+}
+
+bool VariantPool::insertPacked(Variant& array, const Variant& val)
+{
+    if(array.type == Variant::SEQUENCE && !array.packed && !packedArrays.empty() && array.value.Array->empty() &&
+       (val.type == Variant::INT || val.type == Variant::LONG || val.type == Variant::FLOAT || val.type == Variant::DOUBLE))
+    {
+        Variant::PackedArray* packed = packedArrays.back();
+        packedArrays.pop_back();
+        packed->elementType = val.type;
+        packed->reserve(array.value.Array->capacity());
+        recycle(array.value.Array);
+        array.value.Packed = packed;
+        array.packed = true;
+    }
+    return array.insertPacked(val);
+}
+
+void VariantPool::shapeAs(Variant& map, std::shared_ptr<const Shape>& shape)
+{
+    if(map.type != Variant::MAP || map.packed)
+    {
+        map.shapeAs(shape);
+        return;
+    }
+
+    Variant::MapType* entries = map.value.Map;
+    if(!shape || !shape->sameKeys(*entries))
+        shape = findShape(*entries);
+    Variant::ShapedMap* shaped;
+    if(shapedMaps.empty())
+        shaped = new Variant::ShapedMap();
+    else
+    {
+        shaped = shapedMaps.back();
+        shapedMaps.pop_back();
+    }
+    shaped->shape = shape;
+    shaped->values.reserve(entries->size());
+    for(Variant::MapType::iterator it = entries->begin(); it != entries->end(); ++it)
+        shaped->values.push_back(std::move(it->second));
+    recycle(entries);
+    map.value.Shaped = shaped;
+    map.packed = true;
+}
+
+size_t VariantPool::size() const {
+    return strings.size() + arrays.size() + maps.size() + nodes.size() + packedArrays.size() + shapedMaps.size() +
+           shapes.size(); }
+
+void VariantPool::clear()
+{
+    for(size_t i = 0; i < strings.size(); i++)
+        delete strings[i];
+    for(size_t i = 0; i < arrays.size(); i++)
+        delete arrays[i];
+    for(size_t i = 0; i < maps.size(); i++)
+        delete maps[i];
+    for(size_t i = 0; i < packedArrays.size(); i++)
+        delete packedArrays[i];
+    for(size_t i = 0; i < shapedMaps.size(); i++)
+        delete shapedMaps[i];
+    strings.clear();
+    arrays.clear();
+    maps.clear();
+    nodes.clear();
+    packedArrays.clear();
+    shapedMaps.clear();
+    shapes.clear();
+    nextShape = 0;
+}
+
+
+//****************************** Private functions *******************************//
+void VariantPool::detach(Variant& value)
+{
+    value.type = Variant::NULLTYPE;
+    value.value.Long = 0;
+    value.packed = false;
+}
+
+void VariantPool::recycle(Variant::ArrayType* array)
+{
+    if(arrays.size() < maxObjects)
+    {
+        array->clear();
+        arrays.push_back(array);
+    }
+    else
+        delete array;
+}
+
+void VariantPool::recycle(Variant::MapType* map)
+{
+    while(!map->empty() && nodes.size() < maxObjects)
+    {
+        nodes.push_back(map->extract(map->begin()));
+        nodes.back().key() = Key();
+    }
+    if(maps.size() < maxObjects)
+    {
+        map->clear();
+        maps.push_back(map);
+    }
+    else
+        delete map;
+}
+
+std::shared_ptr<const Shape> VariantPool::findShape(const Variant::MapType& map)
+{
+    for(size_t i = 0; i < shapes.size(); i++)
+        if(shapes[i]->sameKeys(map))
+            return shapes[i];
+
+    std::shared_ptr<const Shape> shape = std::make_shared<const Shape>(map);
+    if(maxObjects == 0)
+        return shape;
+    if(shapes.size() < maxShapes)
+        shapes.push_back(shape);
+    else
+    {
+        shapes[nextShape] = shape;
+        nextShape = (nextShape + 1) % maxShapes;
+    }
+    return shape;
+}
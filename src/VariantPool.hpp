@@ -0,0 +1,124 @@
+#ifndef VARIANTPOOL_H
+#define VARIANTPOOL_H
+
+#include "Variant.hpp"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*! \brief Class keeping the storage of released Variant trees, to build the next trees without allocations.
+ *
+ * A tree released with release() gives its strings, arrays, maps and map nodes to the pool, cleared but with their
+ * capacity. The creation methods then take their storage from the pool before allocating anything. It is used by
+ * a reader parsing many small documents one after the other (see BasicDocument):
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * VariantPool pool;
+ * reader.setPool(&pool);
+ * while(...)
+ * {
+ *     pool.release(doc);
+ *     reader.parse(doc);
+ *     process(doc);
+ * }
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *
+ * The storage of the packed arrays and the shaped maps is kept too, and the readers pack and shape the arrays
+ * with it (see ArrayBuilder). The last shapes created are kept, so the records of the next documents share them.
+ * \note A VariantPool is not thread safe, each thread must use its own pool.
+ * \see Variant, BasicDocument
+ */
+class VariantPool
+{
+    public:
+        /*! \brief Construct an empty pool.
+         *
+         * \param maxObjects The maximum number of objects of each kind (strings, arrays, maps, map nodes) kept by
+         * the pool. The objects released above this limit are freed.
+         */
+        explicit VariantPool(size_t maxObjects = 65536);
+
+        ~VariantPool();
+
+        /*! \brief Give the storage of _value_ and of all its elements to the pool, and set it to null.
+         */
+        void release(Variant& value);
+
+        /*! \brief Set _value_ to an empty array, with an array of the pool if there is one.
+         */
+        Variant& createArray(Variant& value);
+
+        /*! \brief Set _value_ to an empty map, with a map of the pool if there is one.
+         */
+        Variant& createMap(Variant& value);
+
+        /*! \brief Set _value_ to a copy of _text_, with a string of the pool if there is one.
+         */
+        Variant& assign(Variant& value, std::string_view text);
+
+        /*! \brief Get the value of _key_ in _map_, set to null.
+         *
+         * A new key is inserted with a node of the pool if there is one.
+         * \throw std::logic_error is thrown if _map_ is not a map.
+         * \see Variant::emplace()
+         */
+        Variant& emplace(Variant& map, Key key);
+
+        /*! \brief Append _val_ to the packed array _array_, like Variant::insertPacked().
+         *
+         * An empty array is converted with a packed array of the pool if there is one.
+         */
+        bool insertPacked(Variant& array, const Variant& val);
+
+        /*! \brief Convert the map _map_ to a shaped map, like Variant::shapeAs().
+         *
+         * The shaped map is taken from the pool if there is one, and the storage of the regular map is given to
+         * the pool. If _shape_ doesn't have the keys of the map, a shape of the pool with these keys is used before
+         * a new one is created.
+         */
+        void shapeAs(Variant& map, std::shared_ptr<const Shape>& shape);
+
+        /*! \brief Get the number of objects kept by the pool.
+         */
+        size_t size() const;
+
+        /*! \brief Free all the objects kept by the pool.
+         */
+        void clear();
+
+
+
+
+    private:
+        size_t maxObjects;                              //!< Maximum number of objects of each kind.
+        std::vector<std::string*> strings;              //!< Released strings.
+        std::vector<Variant::ArrayType*> arrays;        //!< Released arrays.
+        std::vector<Variant::MapType*> maps;            //!< Released maps.
+        std::vector<Variant::MapType::node_type> nodes; //!< Released map nodes, with an empty key and a null value.
+        std::vector<Variant::PackedArray*> packedArrays;    //!< Released packed arrays.
+        std::vector<Variant::ShapedMap*> shapedMaps;        //!< Released shaped maps, without shape.
+        std::vector<std::shared_ptr<const Shape> > shapes;  //!< The last shapes created.
+        size_t nextShape;                                   //!< The slot of shapes replaced by the next shape.
+
+        VariantPool(const VariantPool&) = delete;
+        VariantPool& operator= (const VariantPool&) = delete;
+
+        /*! Set _value_ to null without freeing its storage, already owned by the pool.
+         */
+        static void detach(Variant& value);
+
+        /*! Give the array _array_, with released elements, to the pool or free it.
+         */
+        void recycle(Variant::ArrayType* array);
+
+        /*! Give the map _map_ and its nodes, with released values, to the pool or free them.
+         */
+        void recycle(Variant::MapType* map);
+
+        /*! Get a shape with the keys of _map_, from the pool or created and kept by the pool.
+         */
+        std::shared_ptr<const Shape> findShape(const Variant::MapType& map);
+};
+
+#endif // VARIANTPOOL_H
@@ -1,10 +1,27 @@
 #include "Writer.hpp"
+#include "Shape.hpp"
 #include <stdexcept>
 #include <algorithm>
 #include <fstream>
 #include <sstream>
 
-void Writer::writeInFile(Variant &object, std::string file)
+namespace
+{
+    /*! Write the numbers of a packed array, like the elements of a regular array.
+     */
+    template<class T>
+    void writeNumbers(std::ostream& ostr, ArrayView<T> numbers, const std::string& decalStr)
+    {
+        for(size_t i = 0; i < numbers.size(); i++)
+        {
+            if(i)
+                ostr << ',' << std::endl;
+            ostr << decalStr << numbers[i];
+        }
+    }
+}
+
+void Writer::writeInFile(const Variant &object, std::string file)
 {
     std::ofstream strm(file.c_str(),std::ofstream::out | std::ofstream::trunc);
     if(!strm.is_open())
@@ -14,7 +31,7 @@ void Writer::writeInFile(Variant &object, std::string file)
     writer.write(object);
 }
 
-std::string Writer::writeInString(Variant &object)
+std::string Writer::writeInString(const Variant &object)
 {
     std::ostringstream strm(std::ostringstream::out);
     strm.precision(10);
@@ -27,6 +44,8 @@ std::string Writer::writeInString(Variant &object)
 //******************************** Constructors *******************************//
 Writer::Writer(std::ostream* output)
 {
+    json = false;
+    indent = 4;
     ostr = 0;
     if(!output->good())
         throw std::logic_error("Writer::Writer : stream error");
@@ -46,26 +65,13 @@ void Writer::setStream(std::ostream* output)
 }
 
 
-void Writer::write(Variant &object)
+void Writer::write(const Variant &object)
 {
     if(ostr == 0 || ostr->fail())
         throw std::logic_error("Writer::write : writing error");
     if(object.getType() == Variant::MAP && !json)
     {
-        Variant::MapType::iterator it = object.getMap().begin();
-        Variant::MapType::iterator itend = object.getMap().end();
-        if(it!=itend)
-        {
-            *ostr << '\"' << it->first << "\" : ";
-            writeVariant(it->second);
-            for(++it ; it!=itend; ++it)
-            {
-                *ostr << ',' << std::endl;
-                *ostr << '\"' << it->first << "\" : ";
-                writeVariant(it->second);
-            }
-        }
-
+        writeEntries(object);
     }
     else
     {
@@ -74,7 +80,7 @@ void Writer::write(Variant &object)
     *ostr << std::endl;
 }
 
-void Writer::writeVariant(Variant& var, int decal) const
+void Writer::writeVariant(const Variant& var, int decal) const
 {
     decal += indent;
     std::string decalStr(decal,' ');
@@ -83,8 +89,20 @@ void Writer::writeVariant(Variant& var, int decal) const
         case Variant::SEQUENCE:
             {
                 *ostr << '[' << std::endl;
-                Variant::ArrayType::iterator it = var.getArray().begin();
-                Variant::ArrayType::iterator itend = var.getArray().end();
+                if(var.isPacked())
+                {
+                    switch(var.getPackedType())
+                    {
+                        case Variant::INT:      writeNumbers(*ostr, var.getIntArray(), decalStr); break;
+                        case Variant::LONG:     writeNumbers(*ostr, var.getLongArray(), decalStr); break;
+                        case Variant::FLOAT:    writeNumbers(*ostr, var.getFloatArray(), decalStr); break;
+                        default:                writeNumbers(*ostr, var.getDoubleArray(), decalStr); break;
+                    }
+                    *ostr << " ]";
+                    break;
+                }
+                Variant::ArrayType::const_iterator it = var.getArray().begin();
+                Variant::ArrayType::const_iterator itend = var.getArray().end();
                 if(it!=itend)
                 {
                     *ostr << decalStr;
@@ -103,20 +121,7 @@ void Writer::writeVariant(Variant& var, int decal) const
         case Variant::MAP:
             {
                 *ostr << '{' << std::endl;
-                Variant::MapType::iterator it = var.getMap().begin();
-                Variant::MapType::iterator itend = var.getMap().end();
-                if(it!=itend)
-                {
-                    *ostr << decalStr << '\"' << it->first << "\" : ";
-                    writeVariant(it->second,decal);
-                    for(++it; it!=itend; ++it)
-                    {
-                        *ostr << ',' << std::endl;
-                        *ostr << decalStr << '\"' << it->first << "\" : ";
-                        writeVariant(it->second,decal);
-                    }
-                }
-
+                writeEntries(var,decal);
                 *ostr << " }";
             }
             break;
@@ -152,3 +157,36 @@ void Writer::writeVariant(Variant& var, int decal) const
             break;
     }
 }
+
+void Writer::writeEntries(const Variant& map, int decal) const
+{
+    std::string decalStr(decal,' ');
+    if(map.isShaped())
+    {
+        // read in place, without the copy of the entries made by getMap()
+        const Shape& shape = *map.getShape();
+        ArrayView<Variant> values = map.getShapedValues();
+        for(size_t i = 0; i < values.size(); i++)
+        {
+            if(i)
+                *ostr << ',' << std::endl;
+            *ostr << decalStr << '\"' << shape.key(i) << "\" : ";
+            writeVariant(values[i],decal);
+        }
+        return;
+    }
+
+    Variant::MapType::const_iterator it = map.getMap().begin();
+    Variant::MapType::const_iterator itend = map.getMap().end();
+    if(it!=itend)
+    {
+        *ostr << decalStr << '\"' << it->first << "\" : ";
+        writeVariant(it->second,decal);
+        for(++it; it!=itend; ++it)
+        {
+            *ostr << ',' << std::endl;
+            *ostr << decalStr << '\"' << it->first << "\" : ";
+            writeVariant(it->second,decal);
+        }
+    }
+}
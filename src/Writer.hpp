@@ -8,7 +8,9 @@
 /*! \brief Class providing an interface to write a Variant object into a JSON syntax.
  *
  * The content of a Variant object is wrote in an output stream with a JSON like syntax.
- * \see Variant, Writer
+ * The Variant is only read: the packed arrays and the shaped maps are written in place, without converting them.
+ * To write C++ structures without building a Variant, see ObjectWriter.
+ * \see Variant, ObjectWriter
  */
 class Writer
 {
@@ -23,7 +25,7 @@ class Writer
          * \param file The JSON file name.
          * \throw If the the file cannot be opened, an std::invalid_argument exception is thown.
          */
-        static void writeInFile(Variant &object, std::string file);
+        static void writeInFile(const Variant &object, std::string file);
 
         /*! \brief Write in a string the data of a Variant object.
          *
@@ -31,7 +33,7 @@ class Writer
          * \param object A Variant object containing all the data.
          * \return The resulting string in a JSON syntax.
          */
-        static std::string writeInString(Variant &object);
+        static std::string writeInString(const Variant &object);
 
 
         //**********************************************************************************************//
@@ -62,7 +64,7 @@ class Writer
          * \param object A Variant object containing all the data.
          * \throw An std::logic_error is thrown if the stream is not good.
          */
-        void write(Variant &object);
+        void write(const Variant &object);
 
 
 
@@ -78,7 +80,14 @@ class Writer
          * \param var A Variant object containing the data to write.
          * \param decal The size of the last indentation in number of space.
          */
-        void writeVariant(Variant& var,int decal=0) const;
+        void writeVariant(const Variant& var,int decal=0) const;
+
+        /*! \brief Write the entries of a map, without the braces.
+         *
+         * \param map A Variant object containing a map.
+         * \param decal The size of the indentation of the entries in number of space.
+         */
+        void writeEntries(const Variant& map,int decal=0) const;
 };
 
 #endif // WRITER_H
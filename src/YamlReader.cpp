@@ -0,0 +1,671 @@
+#include "YamlReader.hpp"
+#include "Shape.hpp"
+#include <stdexcept>
+#include <cstdlib>
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    /*! Kind of the entries of a root block collection.
+     */
+    enum RootKind {
+        UNKNOWN_ROOT,   //!< No entry found yet.
+        MAP_ROOT,       //!< The entries are keys.
+        SEQ_ROOT        //!< The entries start with "- ".
+    };
+
+    inline bool isBlank(char c) {
+        return c==' ' || c=='\t'; }
+
+    /*! Check if the line _line_ starts with the marker _marker_ followed by a blank or its end.
+     */
+    bool startsWithMarker(std::string_view line, const char* marker)
+    {
+        return line.compare(0, 3, marker) == 0 && (line.size() == 3 || isBlank(line[3]));
+    }
+
+    /*! Check if the content _line_ ends with a block scalar header (| or >, with its indicators).
+     */
+    bool endsWithBlockHeader(std::string_view line)
+    {
+        size_t end = line.size();
+        while(end > 0 && isBlank(line[end-1]))
+            end--;
+        size_t start = end;
+        while(start > 0 && (line[start-1] == '+' || line[start-1] == '-' || (line[start-1] >= '0' && line[start-1] <= '9')))
+            start--;
+        if(start == 0 || (line[start-1] != '|' && line[start-1] != '>'))
+            return false;
+        return start == 1 || isBlank(line[start-2]);
+    }
+
+    /*! Find the lines starting the top-level entries of the text.
+     *
+     * The lines are scanned for the quotes, the flow collections, the comments and the block scalars, without
+     * parsing the nodes. Return false if the text can't be cut safely.
+     */
+    bool findSections(std::string_view text, std::vector<size_t>& starts, RootKind& kind)
+    {
+        char quote = 0;             // the quote of the scalar continuing on the next line
+        int flowLevel = 0;          // the number of flow collections open
+        long blockIndent = -1;      // the indentation of the line starting a block scalar
+        kind = UNKNOWN_ROOT;
+        starts.clear();
+        starts.push_back(0);
+
+        size_t lineStart = 0;
+        while(lineStart < text.size())
+        {
+            size_t lineEnd = text.find('\n', lineStart);
+            if(lineEnd == std::string_view::npos)
+                lineEnd = text.size();
+            std::string_view line = text.substr(lineStart, lineEnd - lineStart);
+            if(!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            size_t begin = lineStart;
+            lineStart = lineEnd + 1;
+
+            size_t indent = 0;
+            while(indent < line.size() && line[indent] == ' ')
+                indent++;
+            if(indent == line.size() || (line[indent] == '#' && !quote))
+                continue; // blank or comment line
+            if(blockIndent >= 0 && static_cast<long>(indent) > blockIndent)
+                continue; // content of a block scalar
+            blockIndent = -1;
+
+            if(indent == 0)
+            {
+                if(quote || flowLevel > 0 || line[0] == '\t')
+                    return false;
+                if(startsWithMarker(line, "---") || startsWithMarker(line, "...") || line[0] == '%')
+                {
+                    // the markers and directives are only accepted before the root
+                    if(kind != UNKNOWN_ROOT || line.size() > 3)
+                        return false;
+                    continue;
+                }
+                if(line[0] == '?' || line[0] == '[' || line[0] == '{' || line[0] == '|' || line[0] == '>')
+                    return false;
+
+                RootKind entry = line[0] == '-' && (line.size() == 1 || isBlank(line[1])) ? SEQ_ROOT : MAP_ROOT;
+                if(kind == UNKNOWN_ROOT)
+                    kind = entry;
+                else if(entry == kind)
+                    starts.push_back(begin);
+                else if(entry == SEQ_ROOT)
+                    ; // a sequence at the column 0 can be the value of the previous key
+                else
+                    return false;
+            }
+
+            // quotes and flow collections continuing on the next lines
+            char previous = ' ';
+            for(size_t i = indent; i < line.size(); i++)
+            {
+                char c = line[i];
+                if(quote)
+                {
+                    if(quote == '"' && c == '\\')
+                        i++;
+                    else if(c == quote && quote == '\'' && i + 1 < line.size() && line[i+1] == '\'')
+                        i++;
+                    else if(c == quote)
+                        quote = 0;
+                }
+                else if(c == '#' && isBlank(previous))
+                    break;
+                else if((c == '"' || c == '\'') && (isBlank(previous) || previous == '[' || previous == '{' ||
+                                                    previous == ','))
+                    quote = c;
+                else if((c == '&' || c == '*') && (isBlank(previous) || previous == '[' || previous == '{' ||
+                                                  previous == ','))
+                    return false; // an anchor or an alias
+                else if(c == '[' || c == '{')
+                    flowLevel++;
+                else if((c == ']' || c == '}') && flowLevel > 0)
+                    flowLevel--;
+                previous = c;
+            }
+            if(!quote && flowLevel == 0 && endsWithBlockHeader(line))
+                blockIndent = static_cast<long>(indent);
+        }
+        return kind != UNKNOWN_ROOT && !quote && flowLevel == 0;
+    }
+}
+
+void YamlReader::parseFile(Variant &result, std::string file)
+{
+    std::ifstream strm(file.c_str(), std::ifstream::in | std::ifstream::binary);
+    if(!strm.is_open())
+        throw std::invalid_argument("YamlReader::parseFile : Cannot open file");
+    YamlReader reader(&strm);
+    reader.parse(result);
+}
+
+void YamlReader::parseString(Variant &result, std::string text)
+{
+    std::istringstream strm(text, std::istringstream::in | std::istringstream::binary);
+    YamlReader reader(&strm);
+    reader.parse(result);
+}
+
+void YamlReader::parseParallel(Variant &result, std::string_view text, unsigned threadCount)
+{
+    const size_t minChunkSize = 65536;
+    if(threadCount == 0)
+        threadCount = std::thread::hardware_concurrency();
+
+    // the sections are gathered in chunks of about the same size, a few for each thread
+    std::vector<size_t> starts;
+    RootKind kind;
+    size_t bomSize = 0;
+    std::vector<std::string_view> chunks;
+    if(threadCount > 1 && text.size() >= 2 * minChunkSize &&
+       detectEncoding(reinterpret_cast<const unsigned char*>(text.data()), text.size(), bomSize) == UTF8 &&
+       findSections(text, starts, kind))
+    {
+        size_t chunkSize = text.size() / (4 * threadCount);
+        if(chunkSize < minChunkSize)
+            chunkSize = minChunkSize;
+        size_t chunkStart = 0;
+        for(size_t i = 1; i <= starts.size(); i++)
+        {
+            size_t end = i < starts.size() ? starts[i] : text.size();
+            if(end - chunkStart >= chunkSize || i == starts.size())
+            {
+                chunks.push_back(text.substr(chunkStart, end - chunkStart));
+                chunkStart = end;
+            }
+        }
+    }
+    if(chunks.size() < 2)
+    {
+        parseString(result, std::string(text));
+        return;
+    }
+
+    std::vector<Variant> parts(chunks.size());
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    auto readChunks = [&]() {
+        KeyTable keys;
+        size_t i;
+        while((i = next.fetch_add(1)) < chunks.size() && !failed)
+        {
+            try {
+                std::string chunk(chunks[i]);
+                std::istringstream strm(chunk, std::istringstream::in | std::istringstream::binary);
+                YamlReader reader(&strm);
+                reader.setKeyTable(&keys);
+                reader.parse(parts[i]);
+                if(parts[i].getType() != (kind == MAP_ROOT ? Variant::MAP : Variant::SEQUENCE))
+                    failed = true;
+            } catch(std::exception&) {
+                failed = true;
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for(unsigned i = 1; i < threadCount && i < chunks.size(); i++)
+        workers.emplace_back(readChunks);
+    readChunks();
+    for(size_t i = 0; i < workers.size(); i++)
+        workers[i].join();
+
+    if(failed)
+    {
+        // the serial read gives the same errors as parseString()
+        parseString(result, std::string(text));
+        return;
+    }
+
+    result = std::move(parts[0]);
+    if(kind == MAP_ROOT)
+    {
+        // the nodes are moved, and the duplicated keys left in the part replace the previous values
+        Variant::MapType& map = result.getMap();
+        for(size_t i = 1; i < parts.size(); i++)
+        {
+            Variant::MapType& part = parts[i].getMap();
+            map.merge(part);
+            for(Variant::MapType::iterator it = part.begin(); it != part.end(); ++it)
+                map.find(it->first)->second = std::move(it->second);
+        }
+    }
+    else
+    {
+        size_t size = 0;
+        for(size_t i = 0; i < parts.size(); i++)
+            size += parts[i].size();
+        result.reserve(size);
+        ArrayBuilder builder(result);
+        for(size_t i = 1; i < parts.size(); i++)
+            builder.appendAll(parts[i]);
+    }
+}
+
+
+//******************************** Constructors *******************************//
+YamlReader::YamlReader(std::istream* input) :
+    lexer(*input),
+    started(false),
+    nbErrors(0),
+    flowLevel(0),
+    keys(&ownKeys)
+{
+    if(!input->good())
+        throw std::logic_error("YamlReader::YamlReader : stream error");
+    tok.indent = 0;
+    tok.token = END_STREAM;
+}
+
+
+//****************************** Public functions *******************************//
+void YamlReader::parse(Variant &result)
+{
+    if(!next(result))
+        result.setToNull();
+}
+
+bool YamlReader::next(Variant &result)
+{
+    if(!started)
+    {
+        advance(-1);
+        started = true;
+    }
+
+    // end of the previous document
+    while(tok.token == DOCUMENT_END || tok.token == DIRECTIVE)
+        advance(-1);
+    if(tok.token == END_STREAM)
+        return false;
+    if(tok.token == DOCUMENT_START)
+        advance(-1);
+
+    anchors.clear();
+    flowLevel = 0;
+    readNode(result, -1);
+
+    // content after the root node
+    while(tok.token != DOCUMENT_START && tok.token != DOCUMENT_END &&
+          tok.token != DIRECTIVE && tok.token != END_STREAM)
+    {
+        nbErrors++;
+        advance(-1);
+    }
+    return true;
+}
+
+
+void YamlReader::setValidation(bool validate)
+{
+    lexer.setValidation(validate);
+}
+
+void YamlReader::setKeyTable(KeyTable* table)
+{
+    keys = table;
+}
+
+
+//****************************** Private functions *******************************//
+void YamlReader::advance(int indent)
+{
+    tok = lexer.next(indent < 0 ? 0 : indent);
+}
+
+void YamlReader::readNode(Variant& node, int indent)
+{
+    std::string anchor;
+    bool plain = true;
+    node.setToNull();
+
+    // node properties
+    while(tok.token == ANCHOR || tok.token == TAG)
+    {
+        if(tok.token == ANCHOR)
+            anchor = lexer.getValue();
+        else if(lexer.getValue() == "!!str")
+            plain = false;
+        advance(indent);
+    }
+
+    // a node in a block must be more indented than its parent
+    // except for a sequence in a map
+    if(flowLevel == 0 && static_cast<int>(tok.indent) <= indent && tok.token != BLOCK_SEQ_ENTRY)
+    {
+        if(!anchor.empty())
+            anchors[anchor] = node;
+        return;
+    }
+
+    switch(tok.token)
+    {
+        case BLOCK_SEQ_ENTRY:
+            if(flowLevel == 0)
+                readBlockSeq(node, tok.indent);
+            else
+            {
+                nbErrors++;
+                advance(indent);
+            }
+            break;
+        case BLOCK_MAP_ENTRY:
+            if(flowLevel == 0)
+            {
+                std::string key;
+                int col = tok.indent;
+                readKey(key, col);
+                readBlockMap(node, col, key);
+            }
+            else
+                advance(indent);
+            break;
+        case FLOW_SEQ_BEGIN:
+            readFlowSeq(node, indent);
+            break;
+        case FLOW_MAP_BEGIN:
+            readFlowMap(node, indent);
+            break;
+        case SCALAR:
+        case ALIAS:
+            {
+                int col = tok.indent;
+                bool alias = tok.token == ALIAS;
+                plain = plain && lexer.isPlain();
+                scalarBuf = lexer.getValue();
+                advance(indent);
+                if(flowLevel == 0 && tok.token == MAP_KEY_DELIMITER)
+                {
+                    std::string key(scalarBuf);
+                    readBlockMap(node, col, key);
+                }
+                else if(alias)
+                {
+                    std::map<std::string,Variant>::const_iterator it = anchors.find(scalarBuf);
+                    if(it != anchors.end())
+                        node = it->second;
+                    else
+                        nbErrors++;
+                }
+                else
+                    readScalar(node, scalarBuf, plain);
+            }
+            break;
+        case MAP_KEY_DELIMITER:
+        case FLOW_DELIMITER:
+        case FLOW_SEQ_END:
+        case FLOW_MAP_END:
+            if(flowLevel > 0)
+            {
+                // unexpected in this flow collection
+                nbErrors++;
+                advance(indent);
+            }
+            break;
+        default:
+            // empty node
+            break;
+    }
+
+    if(!anchor.empty())
+        anchors[anchor] = node;
+}
+
+void YamlReader::readBlockSeq(Variant& seq, int indent)
+{
+    seq.createArray();
+    ArrayBuilder builder(seq);
+    Variant item;
+    while(tok.token == BLOCK_SEQ_ENTRY && static_cast<int>(tok.indent) == indent)
+    {
+        item.setToNull();
+        advance(indent);
+        if(static_cast<int>(tok.indent) > indent)
+            readNode(item, indent);
+        builder.append(std::move(item));
+    }
+}
+
+void YamlReader::readBlockMap(Variant& map, int indent, std::string& key)
+{
+    map.createMap();
+    while(true)
+    {
+        Variant& value = insertKey(map, key);
+        if(tok.token == MAP_KEY_DELIMITER)
+        {
+            advance(indent);
+            if(static_cast<int>(tok.indent) > indent ||
+               (tok.token == BLOCK_SEQ_ENTRY && static_cast<int>(tok.indent) == indent))
+                readNode(value, indent);
+        }
+
+        // next entry
+        if(static_cast<int>(tok.indent) != indent ||
+           (tok.token != SCALAR && tok.token != ALIAS && tok.token != BLOCK_MAP_ENTRY))
+            break;
+        readKey(key, indent);
+        if(tok.token != MAP_KEY_DELIMITER && tok.token != BLOCK_MAP_ENTRY)
+        {
+            // a key without value
+            insertKey(map, key);
+            break;
+        }
+    }
+}
+
+void YamlReader::readFlowSeq(Variant& seq, int indent)
+{
+    seq.createArray();
+    flowLevel++;
+    advance(indent);
+    ArrayBuilder builder(seq);
+    Variant item;
+    while(tok.token != FLOW_SEQ_END && tok.token != END_STREAM)
+    {
+        if(tok.token == FLOW_DELIMITER)
+        {
+            advance(indent);
+            continue;
+        }
+
+        item.setToNull();
+        bool isScalar = tok.token == SCALAR;
+        if(tok.token != MAP_KEY_DELIMITER)
+            readNode(item, indent);
+
+        // single pair
+        if(tok.token == MAP_KEY_DELIMITER)
+        {
+            std::string key;
+            if(isScalar && item.getType() != Variant::SEQUENCE && item.getType() != Variant::MAP)
+                key = scalarBuf;
+            Variant& value = insertKey(item.createMap(), key);
+            advance(indent);
+            if(tok.token != FLOW_DELIMITER && tok.token != FLOW_SEQ_END)
+                readNode(value, indent);
+        }
+        builder.append(std::move(item));
+    }
+    flowLevel--;
+    if(tok.token == FLOW_SEQ_END)
+        advance(indent);
+}
+
+void YamlReader::readFlowMap(Variant& map, int indent)
+{
+    map.createMap();
+    flowLevel++;
+    advance(indent);
+    std::string key;
+    while(tok.token != FLOW_MAP_END && tok.token != END_STREAM)
+    {
+        if(tok.token == FLOW_DELIMITER)
+        {
+            advance(indent);
+            continue;
+        }
+
+        key.clear();
+        if(tok.token != MAP_KEY_DELIMITER)
+            readKey(key, indent);
+        Variant& value = insertKey(map, key);
+        if(tok.token == MAP_KEY_DELIMITER)
+        {
+            advance(indent);
+            if(tok.token != FLOW_DELIMITER && tok.token != FLOW_MAP_END)
+                readNode(value, indent);
+        }
+        else if(tok.token != FLOW_DELIMITER && tok.token != FLOW_MAP_END)
+        {
+            nbErrors++;
+            advance(indent);
+        }
+    }
+    flowLevel--;
+    if(tok.token == FLOW_MAP_END)
+        advance(indent);
+}
+
+Variant& YamlReader::insertKey(Variant& map, const std::string& key)
+{
+    if(keys)
+        return map.emplace(keys->intern(key));
+    return map.emplace(key);
+}
+
+void YamlReader::readKey(std::string& key, int indent)
+{
+    key.clear();
+    if(tok.token == BLOCK_MAP_ENTRY)
+        advance(indent);
+    while(tok.token == ANCHOR || tok.token == TAG)
+        advance(indent);
+
+    if(tok.token == SCALAR || tok.token == ALIAS)
+    {
+        key = lexer.getValue();
+        advance(indent);
+    }
+    else if(tok.token == FLOW_SEQ_BEGIN || tok.token == FLOW_MAP_BEGIN)
+    {
+        // collections can't be converted to a key
+        Variant skipped;
+        readNode(skipped, indent);
+        nbErrors++;
+    }
+}
+
+
+//********************************* Scalars *********************************//
+inline bool isDigit(char c, int base)
+{
+    switch(base)
+    {
+        case 8:  return c>='0' && c<='7';
+        case 16: return (c>='0' && c<='9') || (c>='a' && c<='f') || (c>='A' && c<='F');
+        default: return c>='0' && c<='9';
+    }
+}
+
+// [-+]?[0-9]+ | 0o[0-7]+ | 0x[0-9a-fA-F]+
+// start is the position of the number after the prefix
+inline bool isInteger(const std::string& str, int& base, size_t& start)
+{
+    size_t i = 0;
+    base = 10;
+    start = 0;
+    if(str.size() > 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'o'))
+    {
+        base = str[1] == 'x' ? 16 : 8;
+        start = i = 2;
+    }
+    else if(str[0] == '-' || str[0] == '+')
+        i = 1;
+    if(i >= str.size())
+        return false;
+    for( ; i < str.size(); i++)
+        if(!isDigit(str[i], base))
+            return false;
+    return true;
+}
+
+// [-+]?(\.[0-9]+|[0-9]+(\.[0-9]*)?)([eE][-+]?[0-9]+)?
+inline bool isFloat(const std::string& str)
+{
+    size_t i = 0;
+    size_t nbDigits = 0;
+    if(str[i] == '-' || str[i] == '+')
+        i++;
+    for( ; i < str.size() && isDigit(str[i], 10); i++)
+        nbDigits++;
+    if(i < str.size() && str[i] == '.')
+        for(i++; i < str.size() && isDigit(str[i], 10); i++)
+            nbDigits++;
+    if(nbDigits == 0)
+        return false;
+    if(i < str.size() && (str[i] == 'e' || str[i] == 'E'))
+    {
+        i++;
+        if(i < str.size() && (str[i] == '-' || str[i] == '+'))
+            i++;
+        if(i >= str.size())
+            return false;
+        for( ; i < str.size(); i++)
+            if(!isDigit(str[i], 10))
+                return false;
+    }
+    return i == str.size();
+}
+
+void YamlReader::readScalar(Variant& node, const std::string& str, bool plain) const
+{
+    if(!plain)
+    {
+        node = str;
+        return;
+    }
+
+    int base;
+    size_t start;
+    if(str.empty() || str == "~" || str == "null" || str == "Null" || str == "NULL")
+        node.setToNull();
+    else if(str == "true" || str == "True" || str == "TRUE")
+        node = true;
+    else if(str == "false" || str == "False" || str == "FALSE")
+        node = false;
+    else if(isInteger(str, base, start))
+    {
+        errno = 0;
+        long long num = strtoll(str.c_str() + start, 0, base);
+        if(errno == ERANGE)
+            node = strtod(str.c_str(), 0);
+        else if(num>=std::numeric_limits<int>::min() && num<=std::numeric_limits<int>::max())
+            node = static_cast<int>(num);
+        else
+            node = num;
+    }
+    else if(isFloat(str))
+        node = strtod(str.c_str(), 0);
+    else
+    {
+        size_t i = (str[0] == '-' || str[0] == '+') ? 1 : 0;
+        std::string special = str.substr(i);
+        if(special == ".inf" || special == ".Inf" || special == ".INF")
+            node = str[0] == '-' ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+        else if(i == 0 && (special == ".nan" || special == ".NaN" || special == ".NAN"))
+            node = std::numeric_limits<double>::quiet_NaN();
+        else
+            node = str;
+    }
+}
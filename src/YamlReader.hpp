@@ -0,0 +1,173 @@
+#ifndef YAMLREADER_H
+#define YAMLREADER_H
+
+#include "Variant.hpp"
+#include "Lexer.hpp"
+#include <istream>
+#include <string>
+#include <string_view>
+#include <map>
+
+/*! \brief Class providing an interface to read a YAML input.
+ *
+ * Parsing methods construct a Variant object containing the data of the stream in a similar structure.
+ * The tokens are extracted by a Lexer object. The input can be encoded in UTF-8, UTF-16 or UTF-32: the Lexer
+ * detects the encoding from the first bytes and converts the other encodings to UTF-8 (see TranscodingBuffer).
+ *
+ * A YAML stream can contain multiple documents separated by the markers <pre> --- </pre> and <pre> ... </pre>.
+ * Each call to next() extracts a single document, and the lexer state and its buffers are kept
+ * from one document to the next:
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~{.cpp}
+ * YamlReader reader(&stream);
+ * Variant doc;
+ * while(reader.next(doc))
+ *     process(doc);
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * \see Variant, Lexer, Reader
+ */
+class YamlReader
+{
+    public:
+        //**********************************************************************************************//
+        //**************************************  Static members  **************************************//
+        //**********************************************************************************************//
+        /*! \brief Read the first document of a YAML file and extract data.
+         *
+         * All the elements of the document are placed in a Variant objet.
+         * \param result A Variant object containing all the data.
+         * \param file The YAML file name.
+         * \throw std::invalid_argument is thown if the the file cannot be opened.
+         */
+        static void parseFile(Variant &result, std::string file);
+
+        /*! \brief Read the first document of a string with a YAML structure and extract data.
+         *
+         * All the elements of the document are placed in a Variant objet.
+         * \param result A Variant object containing all the data.
+         * \param text The input string containig the data.
+         */
+        static void parseString(Variant &result, std::string text);
+
+        /*! \brief Read the first document of a YAML text, parsing its top-level entries on many threads.
+         *
+         * The entries of a root block map or block sequence start at the column 0, so the text is cut at these
+         * lines without parsing it. The sections are read by separate YamlReader objects on a pool of threads,
+         * then joined in their order. The result is the same as with parseString().
+         *
+         * The text is read serially when it can't be cut safely: a root which is not a block collection, a line
+         * at the column 0 inside a flow collection or a quoted scalar, several documents, or anchors and aliases
+         * which could refer to another section. A section which can't be read also falls back to the serial read.
+         * \param result A Variant object containing all the data.
+         * \param text The input text, in UTF-8.
+         * \param threadCount The number of threads reading the sections, or 0 for one per core.
+         */
+        static void parseParallel(Variant &result, std::string_view text, unsigned threadCount = 0);
+
+
+        //**********************************************************************************************//
+        //**************************************  Public methods  **************************************//
+        //**********************************************************************************************//
+        /*! \brief Construct a YamlReader object with the specified input stream.
+         *
+         * The YamlReader object will use the input stream to extract YAML data.
+         * The stream is bound to the internal Lexer, so it cannot be changed afterward.
+         * \note The stream is supposed to be ready to read, and opened in binary mode.
+         * \param input The input stream to read.
+         * \throw std::logic_error is thrown if the stream is not good.
+         */
+        YamlReader(std::istream* input);
+
+        /*! \brief Read the next document of the internal input stream.
+         *
+         * All the elements of the document are placed in a Variant objet.
+         * An empty document is read as a null value.
+         * \param result A Variant object containing all the data.
+         */
+        void parse(Variant &result);
+
+        /*! \brief Read the next document of the internal input stream.
+         *
+         * Documents are separated by the markers <pre> --- </pre> (start of a document)
+         * and <pre> ... </pre> (end of a document). The directives are skipped.
+         * \param result A Variant object receiving the data of the document.
+         * \return false if the end of the stream is reached before any new document, true otherwise.
+         */
+        bool next(Variant &result);
+
+        /*! \brief Validate the encoding of the input while reading it.
+         *
+         * The input is checked block by block just before it is lexed, so an invalid document is rejected
+         * without a separate pass (see TranscodingBuffer). Must be called before reading the first document.
+         * \param validate true to reject the invalid characters, false to accept them.
+         * \throw std::invalid_argument is then thrown by the parsing methods if the input contains an invalid
+         * character.
+         */
+        void setValidation(bool validate);
+
+        /*! \brief Set the table interning the keys of the maps.
+         *
+         * By default, the reader interns the keys in its own table, kept for all the documents it reads.
+         * \param table The table to use, or a null pointer to store a copy of each key.
+         * \see KeyTable
+         */
+        void setKeyTable(KeyTable* table);
+
+
+
+
+    private:
+        Lexer lexer;                            //!< The lexer reading the input stream.
+        Lexer::TokenInfo tok;                   //!< The current token.
+        bool started;                           //!< The first token of the stream has been read.
+        int nbErrors;                           //!< Number of syntax errors found. Not used yet.
+        size_t flowLevel;                       //!< Number of flow collections containing the current node.
+        std::string scalarBuf;                  //!< Text of the last scalar read, reused between documents.
+        std::map<std::string,Variant> anchors;  //!< The anchored nodes of the current document.
+        KeyTable ownKeys;                       //!< The default table of keys.
+        KeyTable* keys;                         //!< The table interning the keys, or null.
+
+
+        /*! Read the next token from the lexer.
+         *  The indentation of the current block is used to end multi-lines scalars.
+         */
+        void advance(int indent);
+
+        /*! Read a node (a collection or a scalar) at the current token.
+         *  The node is part of a block with the indentation _indent_, or of a flow collection.
+         */
+        void readNode(Variant& node, int indent);
+
+        /*! Read the entries of a block sequence with the indentation _indent_.
+         *  Starts on the first entry indicator.
+         */
+        void readBlockSeq(Variant& seq, int indent);
+
+        /*! Read the entries of a block map with the indentation _indent_.
+         *  Starts on the key delimiter following _key_.
+         */
+        void readBlockMap(Variant& map, int indent, std::string& key);
+
+        /*! Read a flow sequence. Ends the read after the symbol ']'.
+         */
+        void readFlowSeq(Variant& seq, int indent);
+
+        /*! Read a flow map. Ends the read after the symbol '}'.
+         */
+        void readFlowMap(Variant& map, int indent);
+
+        /*! Insert _key_ in _map_, interned if there is a table of keys.
+         */
+        Variant& insertKey(Variant& map, const std::string& key);
+
+        /*! Read the text of a key at the current token. Collections can't be used as keys.
+         */
+        void readKey(std::string& key, int indent);
+
+        /*! Convert the text _str_ of a scalar in the best type and place it in _node_.
+         *  Only plain scalars are converted, the others are kept as strings.
+         */
+        void readScalar(Variant& node, const std::string& str, bool plain) const;
+};
+
+#endif // YAMLREADER_H
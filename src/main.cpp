@@ -188,6 +188,16 @@ int main(int argc, char const *argv[])
 					std::cout << "TAG" << t.indent << std::endl;
 					std::cout << "    " << indentStack.top() << " - " << lex.getValue() << std::endl;
 					break;
+				case DIRECTIVE:
+					std::cout << "DIRECTIVE : " << t.indent << std::endl;
+					std::cout << "    " << lex.getValue() << std::endl;
+					break;
+				case DOCUMENT_START:
+					std::cout << "DOCUMENT_START : " << t.indent << std::endl;
+					break;
+				case DOCUMENT_END:
+					std::cout << "DOCUMENT_END : " << t.indent << std::endl;
+					break;
 				default:
 					std::cout << "error" << std::endl;
 					break;